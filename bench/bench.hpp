@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// Utilitários mínimos dos microbenchmarks: cronômetro monotônico e
+// relatório em formato estável de uma linha por resultado, fácil de
+// extrair e acompanhar entre commits:
+//
+//   BENCH name=<nome> n=<ops> ns_op=<ns/op> ops_s=<ops/s> [mb_s=<MB/s>]
+
+namespace aqua::bench {
+
+class Timer {
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    double elapsed_ns() const {
+        auto now = std::chrono::steady_clock::now();
+        return static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - start)
+                .count());
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Emite o resultado; `bytes` > 0 acrescenta a vazão em MB/s
+inline void report(const char* name, double total_ns, size_t ops,
+                   double bytes = 0.0) {
+    double ns_op = ops > 0 ? total_ns / static_cast<double>(ops) : 0.0;
+    double ops_s = total_ns > 0 ? static_cast<double>(ops) * 1e9 / total_ns : 0.0;
+    if (bytes > 0) {
+        std::printf("BENCH name=%s n=%zu ns_op=%.1f ops_s=%.0f mb_s=%.1f\n",
+                    name, ops, ns_op, ops_s, bytes * 1e9 / total_ns / 1e6);
+    } else {
+        std::printf("BENCH name=%s n=%zu ns_op=%.1f ops_s=%.0f\n",
+                    name, ops, ns_op, ops_s);
+    }
+    std::fflush(stdout);
+}
+
+} // namespace aqua::bench
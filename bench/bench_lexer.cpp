@@ -0,0 +1,61 @@
+// Microbenchmark do lexer: vazão de Lexer::tokenize sobre fonte Aqua
+// sintética, relatando ns por token e MB/s
+
+#include "lexer/lexer.hpp"
+#include "bench.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace aqua::lexing;
+
+namespace {
+
+// Gera um programa Aqua repetitivo mas representativo (palavras-chave,
+// identificadores, números, strings, operadores e indentação)
+std::string generate_source(size_t target_bytes) {
+    std::ostringstream out;
+    size_t n = 0;
+    while (static_cast<size_t>(out.tellp()) < target_bytes) {
+        out << "func process_" << n << "(valor, limite)\n";
+        out << "    let total = valor * 2 + " << (n % 97) << "\n";
+        out << "    if total > limite\n";
+        out << "        print(\"acima do limite\")\n";
+        out << "        return total - limite\n";
+        out << "    else\n";
+        out << "        let media = total / 3.14\n";
+        out << "        return media\n";
+        out << "\n";
+        n++;
+    }
+    return out.str();
+}
+
+} // namespace
+
+int main() {
+    constexpr size_t kSourceBytes = 2 * 1024 * 1024;
+    constexpr size_t kIterations = 5;
+
+    std::string source = generate_source(kSourceBytes);
+    std::string_view view(source);
+
+    // Aquecimento e contagem de tokens de uma passada
+    size_t tokens_per_pass = 0;
+    {
+        Lexer lexer(view);
+        tokens_per_pass = lexer.tokenize().size();
+    }
+
+    aqua::bench::Timer timer;
+    for (size_t i = 0; i < kIterations; i++) {
+        Lexer lexer(view);
+        auto tokens = lexer.tokenize();
+        if (tokens.size() != tokens_per_pass) return 1;
+    }
+    double total_ns = timer.elapsed_ns();
+
+    aqua::bench::report("lexer_tokenize", total_ns, tokens_per_pass * kIterations,
+                  static_cast<double>(source.size() * kIterations));
+    return 0;
+}
@@ -0,0 +1,185 @@
+// Microbenchmarks dos caminhos quentes da runtime: canais (com e sem
+// buffer, 1:1 e N:M), latência de spawn do Scheduler e sobrecarga do
+// GarbageCollector. Cada resultado sai em uma linha BENCH (ver bench.hpp)
+
+#include "runtime/runtime.hpp"
+#include "bench.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace aqua;
+
+namespace {
+
+// Canal com buffer, um produtor e um consumidor
+void bench_channel_buffered_1to1() {
+    constexpr size_t kMessages = 100000;
+
+    Runtime& runtime = Runtime::get_instance();
+    runtime.initialize();
+
+    auto channel = runtime.make_channel(1024);
+
+    bench::Timer timer;
+
+    runtime.spawn_fiber([channel]() {
+        for (size_t i = 0; i < kMessages; i++) {
+            channel->send(Value(static_cast<int64_t>(i)));
+        }
+    });
+    runtime.spawn_fiber([channel]() {
+        for (size_t i = 0; i < kMessages; i++) {
+            channel->receive();
+        }
+    });
+
+    runtime.get_scheduler().wait_all();
+    bench::report("channel_buffered_1to1", timer.elapsed_ns(), kMessages);
+
+    runtime.shutdown();
+}
+
+// Canal sem buffer (handoff), um produtor e um consumidor
+void bench_channel_unbuffered_1to1() {
+    constexpr size_t kMessages = 50000;
+
+    Runtime& runtime = Runtime::get_instance();
+    runtime.initialize();
+
+    auto channel = runtime.make_channel(0);
+
+    bench::Timer timer;
+
+    runtime.spawn_fiber([channel]() {
+        for (size_t i = 0; i < kMessages; i++) {
+            channel->send(Value(static_cast<int64_t>(i)));
+        }
+    });
+    runtime.spawn_fiber([channel]() {
+        for (size_t i = 0; i < kMessages; i++) {
+            channel->receive();
+        }
+    });
+
+    runtime.get_scheduler().wait_all();
+    bench::report("channel_unbuffered_1to1", timer.elapsed_ns(), kMessages);
+
+    runtime.shutdown();
+}
+
+// Canal com buffer, quatro produtores e quatro consumidores
+void bench_channel_buffered_4to4() {
+    constexpr size_t kProducers = 4;
+    constexpr size_t kPerProducer = 25000;
+    constexpr size_t kMessages = kProducers * kPerProducer;
+
+    Runtime& runtime = Runtime::get_instance();
+    runtime.initialize();
+
+    auto channel = runtime.make_channel(1024);
+
+    bench::Timer timer;
+
+    for (size_t p = 0; p < kProducers; p++) {
+        runtime.spawn_fiber([channel]() {
+            for (size_t i = 0; i < kPerProducer; i++) {
+                channel->send(Value(static_cast<int64_t>(i)));
+            }
+        });
+    }
+    for (size_t c = 0; c < kProducers; c++) {
+        runtime.spawn_fiber([channel]() {
+            for (size_t i = 0; i < kPerProducer; i++) {
+                channel->receive();
+            }
+        });
+    }
+
+    runtime.get_scheduler().wait_all();
+    bench::report("channel_buffered_4to4", timer.elapsed_ns(), kMessages);
+
+    runtime.shutdown();
+}
+
+// Latência de spawn: fibras vazias criadas e aguardadas em lote
+void bench_spawn() {
+    constexpr size_t kFibers = 20000;
+
+    Runtime& runtime = Runtime::get_instance();
+    runtime.initialize();
+
+    bench::Timer timer;
+
+    for (size_t i = 0; i < kFibers; i++) {
+        runtime.spawn_fiber([]() {});
+    }
+    runtime.get_scheduler().wait_all();
+
+    bench::report("scheduler_spawn", timer.elapsed_ns(), kFibers);
+
+    runtime.shutdown();
+}
+
+// Sobrecarga de register_object/unregister_object (sem disparar coleta)
+void bench_gc_register() {
+    constexpr size_t kObjects = 200000;
+
+    Runtime& runtime = Runtime::get_instance();
+    runtime.initialize();
+
+    GarbageCollector& gc = runtime.get_gc();
+    size_t old_threshold = gc.get_threshold();
+    gc.set_threshold(SIZE_MAX); // evita ciclos de coleta durante a medição
+
+    std::vector<char> arena(kObjects);
+
+    bench::Timer timer;
+    for (size_t i = 0; i < kObjects; i++) {
+        gc.register_object(&arena[i], 1);
+    }
+    for (size_t i = 0; i < kObjects; i++) {
+        gc.unregister_object(&arena[i]);
+    }
+    // Cada objeto conta duas operações: registro e remoção
+    bench::report("gc_register_object", timer.elapsed_ns(), kObjects * 2);
+
+    gc.set_threshold(old_threshold);
+    runtime.shutdown();
+}
+
+// Caminho rápido de alocação (bump pointer no TLAB)
+void bench_gc_alloc() {
+    constexpr size_t kAllocations = 500000;
+    constexpr size_t kSize = 32;
+
+    Runtime& runtime = Runtime::get_instance();
+    runtime.initialize();
+
+    GarbageCollector& gc = runtime.get_gc();
+    size_t old_threshold = gc.get_threshold();
+    gc.set_threshold(SIZE_MAX);
+
+    bench::Timer timer;
+    for (size_t i = 0; i < kAllocations; i++) {
+        volatile void* p = gc.gc_alloc(kSize);
+        (void)p;
+    }
+    bench::report("gc_alloc_32b", timer.elapsed_ns(), kAllocations);
+
+    gc.collect(); // devolve os blocos mortos antes do próximo benchmark
+    gc.set_threshold(old_threshold);
+    runtime.shutdown();
+}
+
+} // namespace
+
+int main() {
+    bench_channel_buffered_1to1();
+    bench_channel_unbuffered_1to1();
+    bench_channel_buffered_4to4();
+    bench_spawn();
+    bench_gc_register();
+    bench_gc_alloc();
+    return 0;
+}
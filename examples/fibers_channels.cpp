@@ -26,7 +26,7 @@ void producer_fiber(std::shared_ptr<Channel> channel, int id) {
 void consumer_fiber(std::shared_ptr<Channel> channel, int id) {
     int count = 0;
     
-    while (count < 10) { // Consumir 10 mensagens no total
+    while (count < 5) { // Cada consumidor processa metade das 10 mensagens
         auto received = channel->receive();
         if (received) {
             std::cout << "📥 Consumidor " << id << " recebeu: " << received->to_string() << std::endl;
@@ -1,24 +1,247 @@
 #include "lexer.hpp"
 #include "utils/error.hpp"
 
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <sstream>
 #include <unordered_map>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 namespace aqua::lexing {
 
-static const std::unordered_set<std::string> kKeywords = {
-    "func","let","import","spawn","match","case","loop","break","continue",
-    "if","else","return","make_channel","sleep","true","false","None",
-    // tipos
-    "int","float","string","bool"
-};
+namespace {
+
+// Kernels de varredura em bloco para os laços quentes do lexer. Corridas de
+// identificador e de espaços nunca contêm '\n', então o chamador pode avançar
+// index/column de uma vez, sem a contabilidade por caractere de advance().
+
+#if defined(__AVX2__)
+
+// Bitmask dos bytes de `chunk` que são [A-Za-z0-9_]
+inline uint32_t identMask32(__m256i chunk) {
+    __m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+    __m256i alpha = _mm256_and_si256(
+        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i digit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk));
+    __m256i under = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_'));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_or_si256(alpha, _mm256_or_si256(digit, under))));
+}
+
+#elif defined(__SSE2__)
+
+// Bitmask dos bytes de `chunk` que são [A-Za-z0-9_]. Bytes >= 0x80 ficam
+// negativos no compare com sinal e saem do run, como no caminho escalar.
+inline uint32_t identMask16(__m128i chunk) {
+    __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    __m128i alpha = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), lower));
+    __m128i digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chunk));
+    __m128i under = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'));
+    return static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_or_si128(alpha, _mm_or_si128(digit, under))));
+}
+
+#endif
+
+// Comprimento da corrida de caracteres de identificador a partir de `pos`
+size_t identRunLength(std::string_view text, size_t pos) {
+    size_t i = pos;
+#if defined(__AVX2__)
+    while (i + 32 <= text.size()) {
+        __m256i chunk = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(text.data() + i));
+        uint32_t mask = identMask32(chunk);
+        if (mask != 0xffffffffu) {
+            return i + static_cast<size_t>(__builtin_ctz(~mask)) - pos;
+        }
+        i += 32;
+    }
+#elif defined(__SSE2__)
+    while (i + 16 <= text.size()) {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(text.data() + i));
+        uint32_t mask = identMask16(chunk);
+        if (mask != 0xffffu) {
+            return i + static_cast<size_t>(__builtin_ctz(~mask & 0xffffu)) - pos;
+        }
+        i += 16;
+    }
+#endif
+    while (i < text.size()) {
+        char c = text[i];
+        bool ident = (std::isalnum(static_cast<unsigned char>(c)) != 0) || c == '_';
+        if (!ident) break;
+        ++i;
+    }
+    return i - pos;
+}
+
+// Comprimento da corrida de espaços (' ') a partir de `pos`
+size_t spaceRunLength(std::string_view text, size_t pos) {
+    size_t i = pos;
+#if defined(__AVX2__)
+    const __m256i space32 = _mm256_set1_epi8(' ');
+    while (i + 32 <= text.size()) {
+        __m256i chunk = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(text.data() + i));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, space32)));
+        if (mask != 0xffffffffu) {
+            return i + static_cast<size_t>(__builtin_ctz(~mask)) - pos;
+        }
+        i += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i space16 = _mm_set1_epi8(' ');
+    while (i + 16 <= text.size()) {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(text.data() + i));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, space16)));
+        if (mask != 0xffffu) {
+            return i + static_cast<size_t>(__builtin_ctz(~mask & 0xffffu)) - pos;
+        }
+        i += 16;
+    }
+#endif
+    while (i < text.size() && text[i] == ' ') {
+        ++i;
+    }
+    return i - pos;
+}
+
+// Posição do próximo caractere especial de corpo de string ('"', '\\' ou
+// '\n') a partir de `pos`; devolve text.size() se não houver
+size_t findStringSpecial(std::string_view text, size_t pos) {
+    size_t i = pos;
+#if defined(__AVX2__)
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    while (i + 32 <= text.size()) {
+        __m256i chunk = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(text.data() + i));
+        __m256i hit = _mm256_or_si256(
+            _mm256_cmpeq_epi8(chunk, quote),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, slash),
+                            _mm256_cmpeq_epi8(chunk, nl)));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        i += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i nl = _mm_set1_epi8('\n');
+    while (i + 16 <= text.size()) {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(text.data() + i));
+        __m128i hit = _mm_or_si128(
+            _mm_cmpeq_epi8(chunk, quote),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, slash),
+                         _mm_cmpeq_epi8(chunk, nl)));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        i += 16;
+    }
+#endif
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '"' || c == '\\' || c == '\n') break;
+        ++i;
+    }
+    return i;
+}
+
+// Classificação de palavra-chave sem tabela e sem alocação: despacho por
+// comprimento e primeiro caractere deixa no máximo uma comparação de
+// memória por lexema (identificadores, o token mais comum, saem em dois
+// ou três ramos). Gerado a mão a partir da lista de palavras-chave; ao
+// acrescentar uma, inclua-a no case do seu comprimento.
+TokenType keywordType(std::string_view w) {
+    switch (w.size()) {
+    case 2:
+        if (w == "if") return TokenType::IF;
+        if (w == "or") return TokenType::OR;
+        break;
+    case 3:
+        switch (w[0]) {
+        case 'l': if (w == "let") return TokenType::LET; break;
+        case 'i': if (w == "int") return TokenType::INT; break;
+        case 'a': if (w == "and") return TokenType::AND; break;
+        case 'n': if (w == "not") return TokenType::NOT; break;
+        }
+        break;
+    case 4:
+        switch (w[0]) {
+        case 'f': if (w == "func") return TokenType::FUNC; break;
+        case 'c': if (w == "case") return TokenType::CASE; break;
+        case 'l': if (w == "loop") return TokenType::LOOP; break;
+        case 'e': if (w == "else") return TokenType::ELSE; break;
+        case 't': if (w == "true") return TokenType::TRUE; break;
+        case 'b': if (w == "bool") return TokenType::BOOL; break;
+        case 'N': if (w == "None") return TokenType::NONE; break;
+        }
+        break;
+    case 5:
+        switch (w[0]) {
+        case 's':
+            if (w == "spawn") return TokenType::SPAWN;
+            if (w == "sleep") return TokenType::SLEEP;
+            break;
+        case 'm': if (w == "match") return TokenType::MATCH; break;
+        case 'b': if (w == "break") return TokenType::BREAK; break;
+        case 'f':
+            if (w == "false") return TokenType::FALSE;
+            if (w == "float") return TokenType::FLOAT;
+            break;
+        }
+        break;
+    case 6:
+        switch (w[0]) {
+        case 'i': if (w == "import") return TokenType::IMPORT; break;
+        case 'r': if (w == "return") return TokenType::RETURN; break;
+        case 's': if (w == "string") return TokenType::STRING_TYPE; break;
+        }
+        break;
+    case 8:
+        if (w == "continue") return TokenType::CONTINUE;
+        break;
+    case 12:
+        if (w == "make_channel") return TokenType::MAKE_CHANNEL;
+        break;
+    }
+    return TokenType::IDENTIFIER;
+}
+
+} // namespace
 
 Lexer::Lexer(std::string source)
-    : input(std::move(source)) {}
+    : ownedInput(std::move(source)), input(ownedInput) {}
+
+Lexer::Lexer(std::string_view source)
+    : input(source) {}
 
 bool Lexer::isKeyword(std::string_view word) {
-    return kKeywords.find(std::string(word)) != kKeywords.end();
+    return keywordType(word) != TokenType::IDENTIFIER;
 }
 
 char Lexer::peek(size_t lookahead) const {
@@ -44,19 +267,35 @@ char Lexer::advance() {
     return c;
 }
 
-void Lexer::emit(TokenType type, const std::string& value) {
-    tokens.push_back(Token{type, value, line, column});
+void Lexer::emit(TokenType type, std::string_view value) {
+    pending.push_back(Token{type, value, line, column});
+}
+
+std::string_view Lexer::slice(size_t start) const {
+    return std::string_view(input).substr(start, index - start);
 }
 
 void Lexer::skipSpaces() {
-    while (!eof() && peek() == ' ' && !atLineStart) {
-        advance();
-    }
+    if (atLineStart) return;
+    size_t run = spaceRunLength(input, index);
+    index += run;
+    column += static_cast<int>(run);
 }
 
 bool Lexer::skipComment() {
     if (!eof() && peek() == '#') {
-        while (!eof() && advance() != '\n') { /* skip */ }
+        // O comentário vai até o fim da linha: achar o '\n' em bloco
+        const char* base = input.data();
+        const void* nl = std::memchr(base + index, '\n', input.size() - index);
+        if (nl) {
+            index = static_cast<size_t>(static_cast<const char*>(nl) - base) + 1;
+            line++;
+            column = 1;
+            atLineStart = true;
+        } else {
+            column += static_cast<int>(input.size() - index);
+            index = input.size();
+        }
         return true;
     }
     return false;
@@ -66,11 +305,11 @@ void Lexer::emitPendingIndents(int indent) {
     int current = indentStack.back();
     if (indent > current) {
         indentStack.push_back(indent);
-        tokens.push_back(Token{TokenType::INDENT, "", line, column});
+        pending.push_back(Token{TokenType::INDENT, "", line, column});
     } else if (indent < current) {
         while (!indentStack.empty() && indentStack.back() > indent) {
             indentStack.pop_back();
-            tokens.push_back(Token{TokenType::DEDENT, "", line, column});
+            pending.push_back(Token{TokenType::DEDENT, "", line, column});
         }
         if (indentStack.empty() || indentStack.back() != indent) {
             throw LexerError(formatError("IndentationError", line, column, "Indentação inválida"));
@@ -81,14 +320,13 @@ void Lexer::emitPendingIndents(int indent) {
 void Lexer::handleNewline() {
     // Consumir o \n
     advance();
-    tokens.push_back(Token{TokenType::NEWLINE, "\n", line - 1, 1});
+    pending.push_back(Token{TokenType::NEWLINE, "\n", line - 1, 1});
 
     // Calcular indentação da próxima linha: apenas espaços; tabs não suportados
-    int indent = 0;
-    while (!eof() && peek() == ' ') {
-        indent++;
-        advance();
-    }
+    size_t run = spaceRunLength(input, index);
+    index += run;
+    column += static_cast<int>(run);
+    int indent = static_cast<int>(run);
     atLineStart = false; // já consumimos espaços do início
 
     // Se a linha está vazia ou comentário, mantenha estado de início de linha para próxima
@@ -107,23 +345,23 @@ std::optional<Token> Lexer::readNumber() {
 
     int startLine = line;
     int startColumn = column;
+    size_t start = index;
 
-    std::string lexeme;
     bool hasDot = false;
 
     while (!eof()) {
         char c = peek();
         if (isDecimalDigit(c)) {
-            lexeme.push_back(advance());
+            advance();
         } else if (c == '.' && !hasDot && isDecimalDigit(peek(1))) {
             hasDot = true;
-            lexeme.push_back(advance());
+            advance();
         } else {
             break;
         }
     }
 
-    return Token{TokenType::NUMBER, lexeme, startLine, startColumn};
+    return Token{TokenType::NUMBER, slice(start), startLine, startColumn};
 }
 
 bool Lexer::isIdentStart(char c) {
@@ -139,41 +377,16 @@ std::optional<Token> Lexer::readIdentifierOrKeyword() {
 
     int startLine = line;
     int startColumn = column;
+    size_t start = index;
 
-    std::string lexeme;
-    while (!eof() && isIdentPart(peek())) {
-        lexeme.push_back(advance());
-    }
+    // A corrida não contém '\n': avançar posição e coluna em bloco
+    size_t run = identRunLength(input, index);
+    index += run;
+    column += static_cast<int>(run);
+    std::string_view lexeme = slice(start);
 
-    // keywords e booleanos/None
-    if (lexeme == "true") return Token{TokenType::TRUE, lexeme, startLine, startColumn};
-    if (lexeme == "false") return Token{TokenType::FALSE, lexeme, startLine, startColumn};
-    if (lexeme == "None") return Token{TokenType::NONE, lexeme, startLine, startColumn};
-
-    if (lexeme == "func") return Token{TokenType::FUNC, lexeme, startLine, startColumn};
-    if (lexeme == "let") return Token{TokenType::LET, lexeme, startLine, startColumn};
-    if (lexeme == "import") return Token{TokenType::IMPORT, lexeme, startLine, startColumn};
-    if (lexeme == "spawn") return Token{TokenType::SPAWN, lexeme, startLine, startColumn};
-    if (lexeme == "match") return Token{TokenType::MATCH, lexeme, startLine, startColumn};
-    if (lexeme == "case") return Token{TokenType::CASE, lexeme, startLine, startColumn};
-    if (lexeme == "loop") return Token{TokenType::LOOP, lexeme, startLine, startColumn};
-    if (lexeme == "break") return Token{TokenType::BREAK, lexeme, startLine, startColumn};
-    if (lexeme == "continue") return Token{TokenType::CONTINUE, lexeme, startLine, startColumn};
-    if (lexeme == "if") return Token{TokenType::IF, lexeme, startLine, startColumn};
-    if (lexeme == "else") return Token{TokenType::ELSE, lexeme, startLine, startColumn};
-    if (lexeme == "return") return Token{TokenType::RETURN, lexeme, startLine, startColumn};
-    if (lexeme == "make_channel") return Token{TokenType::MAKE_CHANNEL, lexeme, startLine, startColumn};
-    if (lexeme == "sleep") return Token{TokenType::SLEEP, lexeme, startLine, startColumn};
-
-    if (lexeme == "int") return Token{TokenType::INT, lexeme, startLine, startColumn};
-    if (lexeme == "float") return Token{TokenType::FLOAT, lexeme, startLine, startColumn};
-    if (lexeme == "string") return Token{TokenType::STRING_TYPE, lexeme, startLine, startColumn};
-    if (lexeme == "bool") return Token{TokenType::BOOL, lexeme, startLine, startColumn};
-    if (lexeme == "and") return Token{TokenType::AND, lexeme, startLine, startColumn};
-    if (lexeme == "or") return Token{TokenType::OR, lexeme, startLine, startColumn};
-    if (lexeme == "not") return Token{TokenType::NOT, lexeme, startLine, startColumn};
-
-    return Token{TokenType::IDENTIFIER, lexeme, startLine, startColumn};
+    // keywords, booleanos e None saem do mesmo despacho (ver keywordType)
+    return Token{keywordType(lexeme), lexeme, startLine, startColumn};
 }
 
 std::optional<Token> Lexer::readString() {
@@ -183,15 +396,41 @@ std::optional<Token> Lexer::readString() {
     int startColumn = column;
 
     advance(); // opening quote
+    size_t contentStart = index;
+
+    // Caminho comum: sem escapes, o lexema é uma view direto da entrada
     std::string result;
+    bool hasEscape = false;
 
     while (!eof()) {
+        // Pular em bloco o trecho sem aspas, escapes ou quebras de linha
+        size_t special = findStringSpecial(input, index);
+        size_t plainLen = special - index;
+        if (plainLen > 0) {
+            if (hasEscape) {
+                result.append(input.data() + index, plainLen);
+            }
+            index += plainLen;
+            column += static_cast<int>(plainLen);
+        }
+        if (eof()) break;
+
         char c = advance();
         if (c == '"') {
-            return Token{TokenType::STRING, result, startLine, startColumn};
+            if (!hasEscape) {
+                auto view = std::string_view(input).substr(contentStart, index - 1 - contentStart);
+                return Token{TokenType::STRING, view, startLine, startColumn};
+            }
+            ownedStrings.push_back(std::move(result));
+            return Token{TokenType::STRING, ownedStrings.back(), startLine, startColumn};
         }
         if (c == '\\') {
             if (eof()) break;
+            if (!hasEscape) {
+                // Primeiro escape: materializar o prefixo já percorrido
+                hasEscape = true;
+                result.assign(input.data() + contentStart, index - 1 - contentStart);
+            }
             char esc = advance();
             switch (esc) {
                 case 'n': result.push_back('\n'); break;
@@ -204,7 +443,7 @@ std::optional<Token> Lexer::readString() {
                     result.push_back(esc);
                     break;
             }
-        } else {
+        } else if (hasEscape) {
             result.push_back(c);
         }
     }
@@ -254,17 +493,14 @@ std::optional<Token> Lexer::readOperatorOrPunct() {
     }
 }
 
-std::vector<Token> Lexer::tokenize() {
-    tokens.clear();
-
-    // Log simples
-    // std::cerr << "[Lexer] Iniciando tokenização..." << std::endl;
-
-    while (!eof()) {
+bool Lexer::scanStep() {
+    while (pending.empty() && !eof()) {
         // Início de linha: processar indentação
         if (atLineStart) {
-            int indent = 0;
-            while (!eof() && peek() == ' ') { indent++; advance(); }
+            size_t run = spaceRunLength(input, index);
+            index += run;
+            column += static_cast<int>(run);
+            int indent = static_cast<int>(run);
             atLineStart = false;
 
             // Linha vazia ou comentário: emite NEWLINE e continua
@@ -274,7 +510,7 @@ std::vector<Token> Lexer::tokenize() {
                 if (peek() == '#') { while (!eof() && advance() != '\n') {} }
                 // consome a quebra (se presente)
                 if (peek() == '\n') { advance(); }
-                tokens.push_back(Token{TokenType::NEWLINE, "\n", line - 1, 1});
+                pending.push_back(Token{TokenType::NEWLINE, "\n", line - 1, 1});
                 continue;
             }
 
@@ -300,27 +536,264 @@ std::vector<Token> Lexer::tokenize() {
         }
 
         // Strings
-        if (auto tok = readString()) { tokens.push_back(*tok); continue; }
+        if (auto tok = readString()) { pending.push_back(*tok); continue; }
         // Número
-        if (auto tok = readNumber()) { tokens.push_back(*tok); continue; }
+        if (auto tok = readNumber()) { pending.push_back(*tok); continue; }
         // Ident/keyword
-        if (auto tok = readIdentifierOrKeyword()) { tokens.push_back(*tok); continue; }
+        if (auto tok = readIdentifierOrKeyword()) { pending.push_back(*tok); continue; }
         // Operador/pontuação
-        if (auto tok = readOperatorOrPunct()) { tokens.push_back(*tok); continue; }
+        if (auto tok = readOperatorOrPunct()) { pending.push_back(*tok); continue; }
 
         // Caractere não reconhecido
         std::string msg = std::string("Caractere não reconhecido '") + peek() + "'";
         throw LexerError(formatError("LexError", line, column, msg));
     }
 
-    // Encerrar com dedents pendentes
-    while (indentStack.size() > 1) {
-        indentStack.pop_back();
-        tokens.push_back(Token{TokenType::DEDENT, "", line, column});
+    if (!pending.empty()) {
+        return true;
+    }
+
+    if (!emittedEof) {
+        // Encerrar com dedents pendentes
+        while (indentStack.size() > 1) {
+            indentStack.pop_back();
+            pending.push_back(Token{TokenType::DEDENT, "", line, column});
+        }
+        pending.push_back(Token{TokenType::END_OF_FILE, "", line, column});
+        emittedEof = true;
+        return true;
+    }
+
+    return false;
+}
+
+Token Lexer::next_token() {
+    while (pending.empty()) {
+        if (!scanStep()) {
+            // Entrada esgotada: continuar devolvendo EOF
+            return Token{TokenType::END_OF_FILE, "", line, column};
+        }
     }
 
-    tokens.push_back(Token{TokenType::END_OF_FILE, "", line, column});
+    Token token = pending.front();
+    pending.pop_front();
+    return token;
+}
+
+std::vector<Token> Lexer::tokenize() {
+    std::vector<Token> tokens;
+    for (;;) {
+        Token token = next_token();
+        tokens.push_back(token);
+        if (token.type == TokenType::END_OF_FILE) {
+            break;
+        }
+    }
     return tokens;
 }
 
+namespace {
+
+// Um início de linha sem indentação é um CANDIDATO a ponto de religada: ao
+// processá-lo com estado limpo, a pilha de indentação está de volta a [0] e
+// comentários nunca atravessam '\n'. Strings, porém, podem conter '\n' cru
+// (ver readString), então a posição pode na verdade estar dentro de um
+// corpo de string — quem usa estes candidatos precisa confirmá-los contra o
+// fluxo de tokens (ver relex) antes de confiar neles.
+bool isTopLevelLineStart(std::string_view text, size_t pos) {
+    if (pos >= text.size()) return false;
+    if (pos != 0 && text[pos - 1] != '\n') return false;
+    char c = text[pos];
+    return c != ' ' && c != '\t' && c != '\n' && c != '#';
+}
+
+// Linha (1-based) em que o offset `pos` está
+int lineAt(std::string_view text, size_t pos) {
+    return 1 + static_cast<int>(
+                   std::count(text.begin(), text.begin() + pos, '\n'));
+}
+
+// Tokens sem lexema próprio no fonte (fronteiras de linha/indentação)
+bool isSynthesized(TokenType type) {
+    return type == TokenType::NEWLINE || type == TokenType::INDENT ||
+           type == TokenType::DEDENT || type == TokenType::END_OF_FILE;
+}
+
+} // namespace
+
+std::vector<Token> Lexer::relex(const std::vector<Token>& oldTokens,
+                                std::string_view oldSource, size_t editPos,
+                                size_t removedLen, size_t insertedLen) {
+    // Edição que não fecha com os dois buffers: re-lexar tudo
+    if (editPos > oldSource.size() || removedLen > oldSource.size() - editPos ||
+        insertedLen > input.size() - editPos ||
+        oldSource.size() - removedLen + insertedLen != input.size()) {
+        return tokenize();
+    }
+
+    const size_t editEnd = editPos + insertedLen;
+    const auto delta = static_cast<std::ptrdiff_t>(insertedLen) -
+                       static_cast<std::ptrdiff_t>(removedLen);
+
+    // Ponto de religada: o início de linha de nível zero mais próximo à
+    // esquerda da edição (0 se não houver — religa do começo do buffer).
+    // Ficar aquém de editPos garante que o caractere examinado é o mesmo
+    // nos dois buffers.
+    size_t restart = 0;
+    for (size_t p = editPos; p-- > 0;) {
+        if (isTopLevelLineStart(input, p)) {
+            restart = p;
+            break;
+        }
+    }
+    const int restartLine = lineAt(input, restart);
+
+    // Prefixo reaproveitado: tudo antes do primeiro token concreto da linha
+    // de religada; os NEWLINE/DEDENTs dessa fronteira ficam no prefixo.
+    // Religando do offset 0 não há prefixo nenhum — nem mesmo NEWLINEs de
+    // linhas em branco iniciais, que o scanner vai reproduzir
+    size_t cut = 0;
+    if (restart > 0) {
+        cut = oldTokens.size();
+        for (size_t i = 0; i < oldTokens.size(); ++i) {
+            if (!isSynthesized(oldTokens[i].type) &&
+                oldTokens[i].line >= restartLine) {
+                cut = i;
+                break;
+            }
+        }
+    }
+
+    // Confirmar a religada contra a lexada velha: se o ponto escolhido era
+    // um início de token de verdade, o lexer velho emitiu um token concreto
+    // exatamente ali (mesma linha, coluna 1). Caso contrário a posição
+    // estava dentro de uma string multilinha e o prefixo não vale — re-lexar
+    // tudo (o estado deste lexer ainda não foi tocado).
+    if (restart > 0 &&
+        (cut == oldTokens.size() || oldTokens[cut].line != restartLine ||
+         oldTokens[cut].column != 1)) {
+        return tokenize();
+    }
+
+    std::vector<Token> result(oldTokens.begin(),
+                              oldTokens.begin() + static_cast<std::ptrdiff_t>(cut));
+
+    // Religar o scanner deste lexer no ponto seguro
+    index = restart;
+    line = restartLine;
+    column = 1;
+    atLineStart = true;
+    indentStack.assign(1, 0);
+    pending.clear();
+    emittedEof = false;
+
+    // Deslocamento de linhas causado pela edição (constante à direita dela)
+    const int lineDelta =
+        lineAt(input, editEnd) - lineAt(oldSource, editPos + removedLen);
+
+    // Candidatos a ressincronização: inícios de linha de nível zero
+    // inteiramente à direita da edição (a quebra anterior também fora do
+    // trecho editado), com suas linhas no buffer novo. São candidatos, não
+    // certezas — uma aspa desbalanceada pela edição transforma o "código"
+    // seguinte em corpo de string, então cada um só vale depois de
+    // conferido contra o fluxo de tokens re-lexado.
+    std::vector<std::pair<size_t, int>> candidates;
+    if (editEnd + 1 < input.size()) {
+        int ln = lineAt(input, editEnd + 1);
+        for (size_t p = editEnd + 1; p < input.size(); ++p) {
+            if (input[p - 1] == '\n' && isTopLevelLineStart(input, p)) {
+                candidates.emplace_back(p, ln);
+            }
+            if (input[p] == '\n') {
+                ++ln;
+            }
+        }
+    }
+
+    // Aponta stopLineNew/suffixStart para o candidato corrente; devolve
+    // false quando eles (ou o sufixo velho) acabam e o resto é lexado
+    // normalmente até o EOF
+    size_t candidateIdx = 0;
+    size_t searchFrom = cut;
+    int stopLineNew = 0;
+    size_t suffixStart = oldTokens.size();
+    auto armCandidate = [&]() -> bool {
+        for (; candidateIdx < candidates.size(); ++candidateIdx) {
+            stopLineNew = candidates[candidateIdx].second;
+            const int stopLineOld = stopLineNew - lineDelta;
+            while (searchFrom < oldTokens.size() &&
+                   (isSynthesized(oldTokens[searchFrom].type) ||
+                    oldTokens[searchFrom].line < stopLineOld)) {
+                ++searchFrom;
+            }
+            if (searchFrom == oldTokens.size()) {
+                return false;
+            }
+            // A emenda só pode ancorar num token de coluna 1 na linha do
+            // candidato: aí as duas lexadas estão comprovadamente com a
+            // pilha de indentação em [0], e os INDENT/DEDENTs do sufixo
+            // velho continuam válidos. Se o fonte velho não tinha um token
+            // assim (o início de linha era corpo de string), o candidato
+            // não serve de âncora.
+            if (oldTokens[searchFrom].line == stopLineOld &&
+                oldTokens[searchFrom].column == 1) {
+                suffixStart = searchFrom;
+                return true;
+            }
+        }
+        return false;
+    };
+    bool haveCandidate = armCandidate();
+
+    // Região re-lexada: até reproduzir, idêntico, o primeiro token concreto
+    // do sufixo velho na fronteira de um candidato — só então os fluxos
+    // ressincronizaram de verdade e o sufixo pode ser emendado. Os
+    // NEWLINE/DEDENTs da fronteira saem do scanner, refletindo o contexto
+    // de indentação novo; o token concreto vem da cópia do sufixo.
+    for (;;) {
+        Token token = next_token();
+        if (token.type == TokenType::END_OF_FILE) {
+            result.push_back(token);
+            return result;
+        }
+
+        while (haveCandidate && !isSynthesized(token.type) &&
+               token.line >= stopLineNew) {
+            const Token& expected = oldTokens[suffixStart];
+            if (token.type == expected.type && token.value == expected.value &&
+                token.column == expected.column &&
+                token.line == expected.line + lineDelta) {
+                // Sufixo confirmado: mesmas fatias, deslocadas para o
+                // buffer novo. Lexemas que não apontam para o fonte velho
+                // (literais estáticos, strings com escape do lexer velho)
+                // são copiados como estão.
+                const char* oldBase = oldSource.data();
+                for (size_t i = suffixStart; i < oldTokens.size(); ++i) {
+                    Token suffixToken = oldTokens[i];
+                    const char* data = suffixToken.value.data();
+                    if (data >= oldBase &&
+                        data < oldBase + oldSource.size()) {
+                        const auto offset =
+                            static_cast<std::ptrdiff_t>(data - oldBase);
+                        suffixToken.value =
+                            input.substr(static_cast<size_t>(offset + delta),
+                                         suffixToken.value.size());
+                    }
+                    suffixToken.line += lineDelta;
+                    result.push_back(suffixToken);
+                }
+                return result;
+            }
+
+            // O token da fronteira não bate com o sufixo velho (aspa
+            // religada, string engolindo o candidato): este candidato não
+            // ressincroniza; o token fica e tentamos o próximo
+            ++candidateIdx;
+            haveCandidate = armCandidate();
+        }
+
+        result.push_back(token);
+    }
+}
+
 } // namespace aqua::lexing
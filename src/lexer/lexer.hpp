@@ -4,7 +4,7 @@
 #include <string_view>
 #include <vector>
 #include <stack>
-#include <unordered_set>
+#include <deque>
 #include <optional>
 
 #include "token.hpp"
@@ -13,27 +13,62 @@ namespace aqua::lexing {
 
 class Lexer {
 public:
+    // Possui uma cópia da fonte
     explicit Lexer(std::string source);
 
+    // Empresta o buffer (zero-cópia, ex.: arquivo mapeado em memória); o
+    // chamador deve mantê-lo vivo enquanto o Lexer e seus tokens existirem
+    explicit Lexer(std::string_view source);
+
+    // Produz o próximo token sob demanda; após o fim da entrada retorna
+    // END_OF_FILE indefinidamente. Indentação pode gerar vários tokens de
+    // uma vez (NEWLINE + INDENT/DEDENTs); eles saem um a um daqui.
+    Token next_token();
+
     // Tokeniza toda a entrada e retorna a lista completa de tokens
+    // (implementado sobre next_token)
     std::vector<Token> tokenize();
 
+    // Re-lexagem incremental: chame num Lexer recém-construído sobre o
+    // buffer JÁ editado, passando os tokens da versão anterior, o buffer
+    // anterior e a edição (offset, bytes removidos, bytes inseridos).
+    // Só a região entre os inícios de linha de nível zero que cercam a
+    // edição é re-lexada; prefixo e sufixo são reaproveitados do vetor
+    // velho (o sufixo com as views e linhas rebaseadas para o buffer
+    // novo). Como strings podem conter '\n' cru, religada e emenda são
+    // confirmadas contra o fluxo de tokens: sem confirmação, a re-lexagem
+    // se estende (até um tokenize() completo, se preciso). O resultado é
+    // idêntico a um tokenize() completo — inclusive no erro lançado. As
+    // mesmas regras de vida valem: este Lexer e os dois buffers precisam
+    // sobreviver aos tokens devolvidos.
+    std::vector<Token> relex(const std::vector<Token>& oldTokens,
+                             std::string_view oldSource, size_t editPos,
+                             size_t removedLen, size_t insertedLen);
+
     // Verifica se uma palavra é palavra-chave
     static bool isKeyword(std::string_view word);
 
 private:
-    // Entrada e posição
-    std::string input;
+    // Entrada e posição. Os lexemas dos tokens são views para `input`, então
+    // o Lexer (e, no modo emprestado, o buffer do chamador) precisa
+    // sobreviver aos tokens que produziu.
+    std::string ownedInput;
+    std::string_view input;
     size_t index{0};
     int line{1};
     int column{1};
 
+    // Strings com escapes não podem ser views da entrada; o conteúdo
+    // decodificado vive aqui (deque: endereços estáveis ao crescer)
+    std::deque<std::string> ownedStrings;
+
     // Controle de indentação
     std::vector<int> indentStack{0};
     bool atLineStart{true};
 
-    // Tokens acumulados
-    std::vector<Token> tokens;
+    // Tokens já produzidos aguardando consumo por next_token
+    std::deque<Token> pending;
+    bool emittedEof{false};
 
     // Leitura básica
     char peek(size_t lookahead = 0) const;
@@ -41,7 +76,14 @@ private:
     char advance();
 
     // Construção de tokens
-    void emit(TokenType type, const std::string& value = "");
+    void emit(TokenType type, std::string_view value = {});
+
+    // Avança o scanner até produzir pelo menos um token em `pending` (ou
+    // esgotar a entrada); retorna false quando não há mais o que produzir
+    bool scanStep();
+
+    // Fatia da entrada [start, index)
+    std::string_view slice(size_t start) const;
 
     // Consumidores
     void skipSpaces();
@@ -4,6 +4,7 @@
 
 #include "../token.hpp"
 #include "../lexer.hpp"
+#include "utils/error.hpp"
 
 using namespace aqua::lexing;
 
@@ -32,6 +33,158 @@ int main() {
         assert(hasDedent);
     }
 
+    {
+        // Classificação de palavras-chave: todas reconhecidas, e vizinhos
+        // próximos (prefixo/sufixo) continuam identificadores
+        const char* keywords[] = {
+            "func","let","import","spawn","match","case","loop","break",
+            "continue","if","else","return","make_channel","sleep","true",
+            "false","None","int","float","string","bool","and","or","not"
+        };
+        for (const char* kw : keywords) {
+            assert(Lexer::isKeyword(kw));
+            std::string code = kw;
+            Lexer lexer(code);
+            auto tokens = lexer.tokenize();
+            assert(tokens[0].type != TokenType::IDENTIFIER);
+            assert(tokens[0].value == kw);
+        }
+        const char* idents[] = {
+            "funcs","le","iff","make_channels","Continue","flot","strings"
+        };
+        for (const char* id : idents) {
+            assert(!Lexer::isKeyword(id));
+            std::string code = id;
+            Lexer lexer(code);
+            auto tokens = lexer.tokenize();
+            assert(tokens[0].type == TokenType::IDENTIFIER);
+        }
+    }
+
+    {
+        // Re-lex incremental: o resultado tem de ser idêntico, token a
+        // token, a um tokenize() completo do buffer editado
+        std::string oldCode =
+            "func main()\n"
+            "    let x = 10\n"
+            "    if x > 5\n"
+            "        print(\"ok\")\n"
+            "\n"
+            "func other()\n"
+            "    let y = 1\n"
+            "    return y\n";
+        Lexer oldLexer(oldCode);
+        auto oldTokens = oldLexer.tokenize();
+
+        auto check = [&](size_t pos, size_t removed,
+                         const std::string& inserted) {
+            std::string newCode = oldCode;
+            newCode.replace(pos, removed, inserted);
+
+            Lexer full(newCode);
+            auto expected = full.tokenize();
+
+            Lexer incremental(newCode);
+            auto got = incremental.relex(oldTokens, oldCode, pos, removed,
+                                         inserted.size());
+
+            assert(got.size() == expected.size());
+            for (size_t i = 0; i < got.size(); ++i) {
+                assert(got[i].type == expected[i].type);
+                assert(got[i].value == expected[i].value);
+                assert(got[i].line == expected[i].line);
+                assert(got[i].column == expected[i].column);
+            }
+        };
+
+        size_t num = oldCode.find("10");
+        check(num, 2, "1234");                      // troca no meio
+        check(num, 2, "7\n        let z = 2");      // insere linha indentada
+        check(0, 4, "func");                        // edição na primeira linha
+        check(oldCode.find("let y"), 5, "lety ");   // perto do fim
+        check(oldCode.size() - 1, 1, "");           // remoção no fim
+        check(oldCode.find("other"), 0, "an");      // só insere
+    }
+
+    {
+        // Re-lex incremental com strings atravessando '\n': edições que
+        // desequilibram (ou religam) aspas têm de dar o mesmo resultado de
+        // um tokenize() completo — inclusive o mesmo erro lançado
+        auto checkSame = [](const std::string& baseCode, size_t pos,
+                            size_t removed, const std::string& inserted) {
+            Lexer baseLexer(baseCode);
+            auto baseTokens = baseLexer.tokenize();
+
+            std::string newCode = baseCode;
+            newCode.replace(pos, removed, inserted);
+
+            // Os lexers ficam neste escopo: os tokens são views para os
+            // buffers deles
+            Lexer full(newCode);
+            bool fullThrew = false;
+            std::vector<Token> expected;
+            try {
+                expected = full.tokenize();
+            } catch (const aqua::LexerError&) {
+                fullThrew = true;
+            }
+
+            Lexer incremental(newCode);
+            bool incrementalThrew = false;
+            std::vector<Token> got;
+            try {
+                got = incremental.relex(baseTokens, baseCode, pos, removed,
+                                        inserted.size());
+            } catch (const aqua::LexerError&) {
+                incrementalThrew = true;
+            }
+
+            assert(fullThrew == incrementalThrew);
+            if (!fullThrew) {
+                assert(got.size() == expected.size());
+                for (size_t i = 0; i < got.size(); ++i) {
+                    assert(got[i].type == expected[i].type);
+                    assert(got[i].value == expected[i].value);
+                    assert(got[i].line == expected[i].line);
+                    assert(got[i].column == expected[i].column);
+                }
+            }
+        };
+
+        std::string code =
+            "func main()\n"
+            "    let x = 10\n"
+            "    if x > 5\n"
+            "        print(\"ok\")\n"
+            "\n"
+            "func other()\n"
+            "    let y = 1\n"
+            "    return y\n";
+
+        // Abre uma aspa solta: o resto do arquivo religa em pares errados e
+        // termina numa string não terminada — os dois caminhos lançam
+        checkSame(code, code.find("10"), 0, "\"");
+
+        // Remove a abertura de "ok": a de fechamento engole os candidatos
+        // de ressincronização até o EOF
+        checkSame(code, code.find("\"ok\""), 1, "");
+
+        // '\n' cru dentro da string: válido (string multilinha), mas o
+        // "início de linha de nível zero" seguinte é corpo de string
+        checkSame(code, code.find("ok\"") + 1, 0, "X\nY");
+
+        // Fonte velha já com string multilinha: a religada para trás não
+        // pode cair no corpo dela (a linha "cd ef" é conteúdo, não código)
+        std::string ml =
+            "let s = \"ab\n"
+            "cd ef\"\n"
+            "let x = 1\n"
+            "let z = 2\n";
+        checkSame(ml, ml.find("ef"), 2, "EF");        // edita dentro do corpo
+        checkSame(ml, ml.find("= 1") + 2, 1, "42");   // edita depois da string
+        checkSame(ml, ml.find("\"ab"), 1, "");        // remove a abertura
+    }
+
     std::cout << "✅ Testes do lexer passaram" << std::endl;
     return 0;
 }
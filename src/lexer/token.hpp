@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <optional>
 #include <ostream>
 
@@ -77,9 +78,12 @@ enum class TokenType {
     END_OF_FILE
 };
 
+// O lexema é uma view: aponta para o buffer de entrada do Lexer (ou para o
+// armazenamento de strings com escapes que ele possui). Tokens só são
+// válidos enquanto o Lexer que os produziu estiver vivo.
 struct Token {
     TokenType type{};
-    std::string value{};
+    std::string_view value{};
     int line{1};
     int column{1};
 };
@@ -1,38 +1,365 @@
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "lexer/token.hpp"
 #include "lexer/lexer.hpp"
+#include "runtime/runtime.hpp"
 
 using namespace aqua::lexing;
 
+namespace {
+
+// Fonte carregada para lexing: de preferência um mmap somente-leitura
+// (zero-cópia; o Lexer empresta o buffer), com fallback para leitura normal.
+class MappedSource {
+public:
+    MappedSource() = default;
+    MappedSource(const MappedSource&) = delete;
+    MappedSource& operator=(const MappedSource&) = delete;
+
+    ~MappedSource() {
+#ifdef __unix__
+        if (mapping && mapping != MAP_FAILED) {
+            munmap(mapping, mappedSize);
+        }
+#endif
+    }
+
+    bool load(const std::string& path) {
+#ifdef __unix__
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat st{};
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+                if (st.st_size == 0) {
+                    close(fd);
+                    return true; // arquivo vazio: view vazia
+                }
+                void* addr = mmap(nullptr, static_cast<size_t>(st.st_size),
+                                  PROT_READ, MAP_PRIVATE, fd, 0);
+                close(fd);
+                if (addr != MAP_FAILED) {
+                    mapping = addr;
+                    mappedSize = static_cast<size_t>(st.st_size);
+                    return true;
+                }
+                // mmap falhou: cair para a leitura normal
+            } else {
+                close(fd);
+            }
+        }
+#endif
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        fallback = buffer.str();
+        return true;
+    }
+
+    std::string_view view() const {
+        if (mapping) {
+            return {static_cast<const char*>(mapping), mappedSize};
+        }
+        return fallback;
+    }
+
+private:
+    void* mapping{nullptr};
+    size_t mappedSize{0};
+    std::string fallback;
+};
+
+// Fluxo binário de tokens (modo --binary): formato compacto que as
+// ferramentas podem mapear com mmap em vez de re-parsear texto.
+//
+//   Cabeçalho (little-endian, tamanho fixo de 16 bytes):
+//     magic   4 bytes  "AQTK"
+//     versão  u32      1
+//     tokens  u64      quantidade de registros
+//   Registros, um por token, três varints LEB128 cada:
+//     tipo, offset e comprimento do lexema no arquivo fonte
+//
+// Tokens sintetizados (NEWLINE/INDENT/DEDENT/EOF) e lexemas processados
+// (strings com escapes) não apontam para o fonte: saem com offset e
+// comprimento zero, e o leitor reconstrói o que precisar pelo tipo.
+// Fluxos concatenados (modo multi-arquivo) são auto-delimitados pela
+// contagem do cabeçalho.
+class BinaryTokenWriter {
+public:
+    explicit BinaryTokenWriter(std::ostream& out) : out(out) {
+        buffer.reserve(kFlushAt + 32);
+    }
+
+    ~BinaryTokenWriter() { flush(); }
+
+    void writeHeader(uint64_t tokenCount) {
+        buffer.append("AQTK", 4);
+        u32(1);
+        u64(tokenCount);
+    }
+
+    void writeToken(uint64_t type, uint64_t offset, uint64_t length) {
+        varint(type);
+        varint(offset);
+        varint(length);
+        if (buffer.size() >= kFlushAt) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (!buffer.empty()) {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+
+private:
+    static constexpr size_t kFlushAt = 64 * 1024;
+
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) buffer.push_back(static_cast<char>(v >> (8 * i)));
+    }
+
+    void u64(uint64_t v) {
+        for (int i = 0; i < 8; ++i) buffer.push_back(static_cast<char>(v >> (8 * i)));
+    }
+
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            buffer.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        buffer.push_back(static_cast<char>(v));
+    }
+
+    std::ostream& out;
+    std::string buffer;
+};
+
+// Cache de tokens por conteúdo (modo --binary --cache): o fluxo AQTK de
+// cada fonte fica guardado em <dir>/<hash>.aqtk, chaveado pelo hash do
+// conteúdo — arquivo inalterado vira um mmap do cache, sem re-lexar.
+// O cache é melhor esforço: qualquer falha de E/S só custa um re-lex.
+
+// Hash FNV-1a de 64 bits do fonte: sem dependências, rápido o bastante
+// (uma passada) e com colisões irrelevantes para esta escala
+uint64_t hashSource(std::string_view s) {
+    uint64_t h = 1469598103934665603ull;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string cachePath(const std::string& dir, uint64_t hash) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.aqtk",
+                  static_cast<unsigned long long>(hash));
+    return dir + "/" + name;
+}
+
+// Acerto de cache: despejar o fluxo armazenado (validando o magic) em `out`
+bool emitCached(const std::string& dir, uint64_t hash, std::ostream& out) {
+    MappedSource cached;
+    if (!cached.load(cachePath(dir, hash))) {
+        return false;
+    }
+    std::string_view bytes = cached.view();
+    if (bytes.size() < 16 || bytes.substr(0, 4) != "AQTK") {
+        return false;
+    }
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return true;
+}
+
+// Popular o cache: escrever num temporário e renomear, para que leitores
+// concorrentes nunca vejam um fluxo pela metade
+void storeCached(const std::string& dir, uint64_t hash,
+                 const std::string& bytes) {
+#ifdef __unix__
+    mkdir(dir.c_str(), 0755); // já existir é o caso comum
+#endif
+    std::string path = cachePath(dir, hash);
+#ifdef __unix__
+    std::string tmp = path + ".tmp" + std::to_string(::getpid());
+#else
+    std::string tmp = path + ".tmp";
+#endif
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return;
+        }
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file) {
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    std::rename(tmp.c_str(), path.c_str());
+}
+
+// Lexa um arquivo escrevendo os tokens em `out`; retorna false em erro.
+// `cacheDir` não nulo ativa o cache de tokens (só no modo binário).
+bool lexFile(const std::string& filename, bool printHeader, bool binary,
+             const std::string* cacheDir, std::ostream& out,
+             std::ostream& err) {
+    MappedSource source;
+    if (!source.load(filename)) {
+        err << "Erro ao abrir arquivo: " << filename << "\n";
+        return false;
+    }
+
+    // No modo binário o cabeçalho AQTK já delimita o fluxo
+    if (printHeader && !binary) {
+        out << "# " << filename << "\n";
+    }
+
+    try {
+        std::string_view src = source.view();
+
+        // Acerto de cache: nem tokenizar — o fluxo pronto sai do mmap
+        uint64_t hash = 0;
+        bool useCache = binary && cacheDir;
+        if (useCache) {
+            hash = hashSource(src);
+            if (emitCached(*cacheDir, hash, out)) {
+                return true;
+            }
+        }
+
+        Lexer lexer(src);
+        auto tokens = lexer.tokenize();
+        if (binary) {
+            // Com cache, serializar em memória para gravar e emitir o
+            // mesmo fluxo; sem cache, direto no destino
+            std::ostringstream cacheStream;
+            std::ostream& sink = useCache ? cacheStream : out;
+            {
+                BinaryTokenWriter writer(sink);
+                writer.writeHeader(tokens.size());
+                for (const auto& t : tokens) {
+                    const char* data = t.value.data();
+                    uint64_t offset = 0;
+                    uint64_t length = 0;
+                    if (data >= src.data() && data < src.data() + src.size()) {
+                        offset = static_cast<uint64_t>(data - src.data());
+                        length = t.value.size();
+                    }
+                    writer.writeToken(static_cast<uint64_t>(t.type), offset,
+                                      length);
+                }
+            }
+            if (useCache) {
+                std::string bytes = cacheStream.str();
+                out.write(bytes.data(),
+                          static_cast<std::streamsize>(bytes.size()));
+                storeCached(*cacheDir, hash, bytes);
+            }
+        } else {
+            for (const auto& t : tokens) {
+                out << t << "\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        err << filename << ": " << e.what() << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+// Resultado por arquivo do modo paralelo, emitido em ordem determinística
+struct FileResult {
+    std::string output;
+    std::string errors;
+    bool ok{true};
+};
+
+// Lexa vários arquivos em paralelo com uma fibra por arquivo; os buffers
+// por arquivo garantem saída na ordem da linha de comando
+bool lexFilesParallel(const std::vector<std::string>& files, bool binary,
+                      const std::string* cacheDir) {
+    std::vector<FileResult> results(files.size());
+
+    aqua::Runtime& runtime = aqua::Runtime::get_instance();
+    runtime.initialize();
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        runtime.spawn_fiber([&files, &results, binary, cacheDir, i]() {
+            std::ostringstream out;
+            std::ostringstream err;
+            results[i].ok = lexFile(files[i], true, binary, cacheDir, out, err);
+            results[i].output = out.str();
+            results[i].errors = err.str();
+        });
+    }
+
+    runtime.get_scheduler().wait_all();
+    runtime.shutdown();
+
+    bool ok = true;
+    for (const auto& result : results) {
+        std::cout << result.output;
+        std::cerr << result.errors;
+        ok = ok && result.ok;
+    }
+    return ok;
+}
+
+} // namespace
+
 int main(int argc, char** argv) {
     std::ios::sync_with_stdio(false);
 
-    if (argc < 2) {
-        std::cerr << "Uso: aqua-lexer <arquivo.aqua>" << std::endl;
-        return 1;
+    bool binary = false;
+    bool cache = false;
+    std::string cacheDir = ".aqua-cache";
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--binary") {
+            binary = true;
+        } else if (arg == "--cache") {
+            cache = true;
+        } else if (arg.rfind("--cache=", 0) == 0) {
+            cache = true;
+            cacheDir = std::string(arg.substr(8));
+        } else {
+            files.emplace_back(arg);
+        }
     }
 
-    const std::string filename = argv[1];
-    std::ifstream in(filename);
-    if (!in) {
-        std::cerr << "Erro ao abrir arquivo: " << filename << std::endl;
+    if (files.empty()) {
+        std::cerr << "Uso: aqua-lexer [--binary] [--cache[=dir]] <arquivo.aqua> [mais arquivos...]" << std::endl;
         return 1;
     }
 
-    std::ostringstream buffer;
-    buffer << in.rdbuf();
-    std::string source = buffer.str();
-
-    Lexer lexer(source);
-    auto tokens = lexer.tokenize();
+    // O cache guarda fluxos AQTK, então só faz sentido no modo binário
+    const std::string* cacheArg = (cache && binary) ? &cacheDir : nullptr;
 
-    for (const auto& t : tokens) {
-        std::cout << t << "\n";
+    if (files.size() == 1) {
+        return lexFile(files[0], false, binary, cacheArg, std::cout, std::cerr)
+                   ? 0
+                   : 1;
     }
 
-    return 0;
+    return lexFilesParallel(files, binary, cacheArg) ? 0 : 1;
 }
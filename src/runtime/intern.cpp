@@ -0,0 +1,137 @@
+#include "intern.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace aqua {
+
+namespace detail {
+
+namespace {
+
+// Tabela global de internamento, particionada em shards para que threads
+// internando strings diferentes raramente disputem o mesmo lock. As chaves
+// são views para o próprio conteúdo das células (estável no heap).
+constexpr size_t kShardCount = 16;
+
+struct InternShard {
+    std::mutex mutex;
+    std::unordered_map<std::string_view, StringCell*> table;
+};
+
+InternShard& shard_for(size_t hash) {
+    static InternShard shards[kShardCount];
+    return shards[hash % kShardCount];
+}
+
+} // namespace
+
+StringCell* intern_cell(std::string_view text) {
+    size_t hash = std::hash<std::string_view>{}(text);
+    InternShard& shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.table.find(text);
+    if (it != shard.table.end()) {
+        it->second->refs.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+    }
+
+    // A célula nasce com a referência da tabela; soma-se a do chamador
+    auto* cell = new StringCell(std::string(text));
+    cell->interned = true;
+    cell->hash = hash;
+    cell->refs.fetch_add(1, std::memory_order_relaxed);
+    shard.table.emplace(std::string_view(cell->str), cell);
+    return cell;
+}
+
+void intern_release(RefCell* base) {
+    auto* cell = static_cast<StringCell*>(base);
+
+    // Caminho rápido: com outras referências externas vivas, basta
+    // decrementar. A carga é uma dica — se dois releases cruzados deixarem
+    // a contagem em 1 sem ninguém entrar no caminho lento, a entrada
+    // apenas fica na tabela e o próximo ciclo intern/release a remove.
+    if (cell->refs.load(std::memory_order_acquire) > 2) {
+        cell->refs.fetch_sub(1, std::memory_order_acq_rel);
+        return;
+    }
+
+    // Possível última referência externa: decidir sob o lock do shard,
+    // ainda segurando a nossa referência — ninguém pode destruir a célula
+    // nem removê-la da tabela enquanto isso. O shard sai do hash gravado
+    // no internamento, sem tocar em cell->str antes do lock.
+    InternShard& shard = shard_for(cell->hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (cell->refs.fetch_sub(1, std::memory_order_acq_rel) != 2) {
+        // Ainda há referências externas (alguém reinternou entre a carga e
+        // o lock); nada a remover
+        return;
+    }
+
+    // Restou só a referência da tabela. Conferir a identidade antes de
+    // remover: a entrada precisa ainda apontar para esta célula exata.
+    auto it = shard.table.find(std::string_view(cell->str));
+    if (it == shard.table.end() || it->second != cell) {
+        return;
+    }
+    shard.table.erase(it);
+    if (cell->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete cell;
+    }
+}
+
+} // namespace detail
+
+InternedString::InternedString(std::string_view text)
+    : cell(detail::intern_cell(text)) {}
+
+InternedString::InternedString(const InternedString& other) : cell(other.cell) {
+    if (cell) {
+        cell->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+InternedString::InternedString(InternedString&& other) noexcept : cell(other.cell) {
+    other.cell = nullptr;
+}
+
+InternedString& InternedString::operator=(const InternedString& other) {
+    if (this != &other) {
+        if (other.cell) {
+            other.cell->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        this->~InternedString();
+        cell = other.cell;
+    }
+    return *this;
+}
+
+InternedString& InternedString::operator=(InternedString&& other) noexcept {
+    if (this != &other) {
+        this->~InternedString();
+        cell = other.cell;
+        other.cell = nullptr;
+    }
+    return *this;
+}
+
+InternedString::~InternedString() {
+    if (cell) {
+        detail::intern_release(cell);
+        cell = nullptr;
+    }
+}
+
+std::string_view InternedString::view() const {
+    return cell ? std::string_view(cell->str) : std::string_view{};
+}
+
+const std::string& InternedString::str() const {
+    static const std::string empty;
+    return cell ? cell->str : empty;
+}
+
+} // namespace aqua
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "runtime.hpp"
+
+namespace aqua {
+
+// Handle refcontado para uma string internada na tabela global. Strings
+// idênticas compartilham a mesma célula, então copiar o handle (ou um Value
+// de string) nunca duplica os bytes. Usável tanto pela runtime (Value)
+// quanto pelo lexer para lexemas repetidos.
+class InternedString {
+public:
+    InternedString() = default;
+    explicit InternedString(std::string_view text);
+
+    InternedString(const InternedString& other);
+    InternedString(InternedString&& other) noexcept;
+    InternedString& operator=(const InternedString& other);
+    InternedString& operator=(InternedString&& other) noexcept;
+    ~InternedString();
+
+    std::string_view view() const;
+    const std::string& str() const;
+    bool empty() const { return cell == nullptr; }
+
+    bool operator==(const InternedString& other) const {
+        // Strings internadas iguais compartilham a mesma célula
+        return cell == other.cell;
+    }
+
+private:
+    friend class Value;
+
+    detail::StringCell* cell{nullptr};
+};
+
+namespace detail {
+
+// Interna o texto na tabela global (sharded) e devolve a célula com uma
+// referência já contada para o chamador.
+StringCell* intern_cell(std::string_view text);
+
+// Solta uma referência de uma célula internada. Quando ela pode ser a
+// última fora da tabela, o decremento acontece sob o lock do shard — o
+// chamador ainda segura a referência, então a célula não morre no meio —
+// e a remoção só ocorre se a tabela ainda apontar para esta célula.
+void intern_release(RefCell* cell);
+
+} // namespace detail
+
+} // namespace aqua
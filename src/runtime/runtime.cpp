@@ -1,20 +1,131 @@
 #include "runtime.hpp"
+#include "intern.hpp"
 #include <iostream>
 #include <sstream>
 #include <chrono>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 
 #ifdef __linux__
 #include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <pthread.h>
+#include <cerrno>
+#include <unistd.h>
 #elif defined(__APPLE__)
 #include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #else
 // Para Windows, usar fibers nativas ou implementação alternativa
 #endif
 
 namespace aqua {
 
+// Estado por worker: contexto do agendador e fibra em execução. Permite que
+// yield/bloqueio em canal salve o contexto da fibra e devolva o controle ao
+// worker_loop sem desmontar a pilha.
+static thread_local ucontext_t* tl_worker_context = nullptr;
+static thread_local Fiber* tl_current_fiber = nullptr;
+static thread_local std::shared_ptr<Fiber> tl_current_handle;
+
+// Identidade do worker dentro do seu agendador (-1 fora de workers)
+static thread_local Scheduler* tl_worker_scheduler = nullptr;
+static thread_local size_t tl_worker_index = 0;
+
+// Instrumentação dos caminhos quentes: cada thread incrementa seu próprio
+// bloco de contadores com atômicos relaxed (sem compartilhamento falso nem
+// contenção); Runtime::stats() soma os blocos sob demanda. Compilar com
+// -DAQUA_NO_STATS remove tudo isto.
+#ifndef AQUA_NO_STATS
+namespace {
+
+struct StatsBlock {
+    std::atomic<uint64_t> fibers_executed{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> channel_sends{0};
+    std::atomic<uint64_t> channel_receives{0};
+    std::atomic<uint64_t> channel_blocking_waits{0};
+    std::atomic<uint64_t> gc_bytes_allocated{0};
+    std::atomic<uint64_t> gc_bytes_freed{0};
+    std::atomic<uint64_t> gc_pause_ns{0};
+};
+
+std::mutex stats_registry_mutex;
+
+// Os blocos vivem até o fim do processo: threads vêm e vão, mas seus
+// totais continuam contando na agregação
+std::vector<std::unique_ptr<StatsBlock>>& stats_registry() {
+    static std::vector<std::unique_ptr<StatsBlock>> registry;
+    return registry;
+}
+
+StatsBlock& local_stats() {
+    thread_local StatsBlock* block = [] {
+        auto owned = std::make_unique<StatsBlock>();
+        StatsBlock* raw = owned.get();
+        std::lock_guard<std::mutex> lock(stats_registry_mutex);
+        stats_registry().push_back(std::move(owned));
+        return raw;
+    }();
+    return *block;
+}
+
+} // namespace
+
+#define AQUA_STAT_ADD(field, n) \
+    (local_stats().field.fetch_add((n), std::memory_order_relaxed))
+
+namespace {
+
+// Mede a duração de uma fatia de GC e acumula em gc_pause_ns ao sair
+class ScopedGcPause {
+public:
+    ScopedGcPause() : begin(std::chrono::steady_clock::now()) {}
+    ~ScopedGcPause() {
+        AQUA_STAT_ADD(gc_pause_ns,
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - begin)
+                          .count());
+    }
+
+private:
+    std::chrono::steady_clock::time_point begin;
+};
+
+} // namespace
+#else
+#define AQUA_STAT_ADD(field, n) ((void)0)
+
+namespace {
+struct ScopedGcPause {
+    ScopedGcPause() {}
+};
+} // namespace
+#endif
+
 // Implementação da classe Value
+Value::Value(const ValueType& val) : Value() {
+    std::visit([this](const auto& v) { *this = Value(v); }, val);
+}
+
+Value::Value(const InternedString& val) : tag(Tag::String) {
+    if (val.cell) {
+        val.cell->refs.fetch_add(1, std::memory_order_relaxed);
+        payload.cell = val.cell;
+    } else {
+        payload.cell = detail::intern_cell("");
+    }
+}
+
 std::string Value::type_name() const {
     if (is<std::nullptr_t>()) return "null";
     if (is<bool>()) return "bool";
@@ -36,304 +147,1771 @@ std::string Value::to_string() const {
 }
 
 // Implementação da classe Channel
-Channel::Channel(size_t buffer_size) 
+Channel::Channel(size_t buffer_size)
     : max_size(buffer_size), closed(false) {
+    if (max_size > 0) {
+        ring = std::make_unique<RingSlot[]>(max_size);
+        for (size_t i = 0; i < max_size; ++i) {
+            ring[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
 }
 
 Channel::~Channel() = default;
 
+bool Channel::try_ring_send(const Value& value) {
+    return try_ring_send(Value(value));
+}
+
+bool Channel::try_ring_send(Value&& value) {
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        RingSlot& slot = ring[pos % max_size];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            // Slot livre: reivindicar a posição e escrever
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed)) {
+                slot.value = std::move(value);
+                slot.seq.store(pos + 1, std::memory_order_release);
+                AQUA_STAT_ADD(channel_sends, 1);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // anel cheio
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+std::optional<Value> Channel::try_ring_receive() {
+    size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        RingSlot& slot = ring[pos % max_size];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            // Slot pronto: reivindicar e mover o valor para fora
+            if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed)) {
+                Value value(std::move(slot.value));
+                slot.value = Value();
+                slot.seq.store(pos + max_size, std::memory_order_release);
+                AQUA_STAT_ADD(channel_receives, 1);
+                return value;
+            }
+        } else if (diff < 0) {
+            return std::nullopt; // anel vazio
+        } else {
+            pos = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Channel::wake_receiver() {
+    if (recv_sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        wake_one(recv_waiters);
+        notify_selects(recv_selects);
+        not_empty.notify_one();
+    }
+}
+
+void Channel::wake_sender() {
+    if (send_sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        wake_one(send_waiters);
+        notify_selects(send_selects);
+        not_full.notify_one();
+    }
+}
+
+void Channel::wake_receivers(size_t count) {
+    if (recv_sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < count && !recv_waiters.empty(); ++i) {
+            wake_one(recv_waiters);
+        }
+        notify_selects(recv_selects);
+        not_empty.notify_all();
+    }
+}
+
+void Channel::wake_senders(size_t count) {
+    if (send_sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < count && !send_waiters.empty(); ++i) {
+            wake_one(send_waiters);
+        }
+        notify_selects(send_selects);
+        not_full.notify_all();
+    }
+}
+
+void Channel::add_select_waiter(
+    const std::shared_ptr<detail::SelectWaiter>& waiter, bool for_receive) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (for_receive) {
+        recv_selects.push_back(waiter);
+        recv_sleepers.fetch_add(1);
+    } else {
+        send_selects.push_back(waiter);
+        send_sleepers.fetch_add(1);
+    }
+}
+
+void Channel::remove_select_waiter(const detail::SelectWaiter* waiter,
+                                   bool for_receive) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& selects = for_receive ? recv_selects : send_selects;
+    for (size_t i = 0; i < selects.size(); ++i) {
+        if (selects[i].get() == waiter) {
+            selects[i] = selects.back();
+            selects.pop_back();
+            (for_receive ? recv_sleepers : send_sleepers).fetch_sub(1);
+            return;
+        }
+    }
+}
+
+void Channel::notify_selects(
+    std::vector<std::shared_ptr<detail::SelectWaiter>>& waiters) {
+    for (auto& waiter : waiters) {
+        waiter->notify();
+    }
+}
+
+void detail::SelectWaiter::notify() {
+    std::shared_ptr<Fiber> target;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        signaled = true;
+        target = fiber;
+    }
+    cv.notify_all();
+    if (target) {
+        Runtime::get_instance().get_scheduler().unpark(target);
+    }
+}
+
+void Channel::block_fiber(std::unique_lock<std::mutex>& lock,
+                          std::queue<std::shared_ptr<Fiber>>& waiters) {
+    AQUA_STAT_ADD(channel_blocking_waits, 1);
+    waiters.push(Scheduler::current_fiber_handle());
+    lock.unlock();
+    Scheduler::suspend_current();
+    lock.lock();
+}
+
+void Channel::wake_one(std::queue<std::shared_ptr<Fiber>>& waiters) {
+    if (!waiters.empty()) {
+        auto fiber = waiters.front();
+        waiters.pop();
+        Runtime::get_instance().get_scheduler().unpark(fiber);
+    }
+}
+
+void Channel::wake_all_locked() {
+    while (!recv_waiters.empty()) {
+        wake_one(recv_waiters);
+    }
+    while (!send_waiters.empty()) {
+        wake_one(send_waiters);
+    }
+    notify_selects(recv_selects);
+    notify_selects(send_selects);
+    not_empty.notify_all();
+    not_full.notify_all();
+}
+
 bool Channel::send(const Value& value) {
+    // Uma cópia aqui e o resto do caminho segue por movimento
+    return send(Value(value));
+}
+
+bool Channel::send(Value&& value) {
+    if (ring) {
+        if (closed_flag.load()) {
+            return false;
+        }
+
+        // Caminho rápido: enfileirar direto no anel, sem lock
+        if (try_ring_send(std::move(value))) {
+            wake_receiver();
+            return true;
+        }
+
+        // Anel cheio: registrar-se como dormente e esperar espaço. O retry
+        // após o incremento de send_sleepers fecha a corrida com um receive
+        // que drena o anel antes de ver o contador. `value` só é movido no
+        // envio que deu certo, então as tentativas podem repeti-lo.
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            if (closed_flag.load()) {
+                return false;
+            }
+            send_sleepers.fetch_add(1);
+            if (try_ring_send(std::move(value))) {
+                send_sleepers.fetch_sub(1);
+                lock.unlock();
+                wake_receiver();
+                return true;
+            }
+            if (Scheduler::current_fiber()) {
+                block_fiber(lock, send_waiters);
+            } else {
+                AQUA_STAT_ADD(channel_blocking_waits, 1);
+                not_full.wait(lock);
+            }
+            send_sleepers.fetch_sub(1);
+        }
+    }
+
+    // Canal sem buffer: fila ilimitada protegida por mutex
     std::unique_lock<std::mutex> lock(mutex);
-    
+
     if (closed) {
         return false;
     }
-    
-    // Se o canal tem buffer limitado, aguardar espaço
-    if (max_size > 0 && buffer.size() >= max_size) {
-        not_full.wait(lock, [this] { return buffer.size() < max_size || closed; });
-        if (closed) return false;
-    }
-    
-    buffer.push(value);
+
+    buffer.push_back(std::move(value));
+    AQUA_STAT_ADD(channel_sends, 1);
+    wake_one(recv_waiters);
+    notify_selects(recv_selects);
     not_empty.notify_one();
     return true;
 }
 
+size_t Channel::send_many(const std::vector<Value>& values) {
+    if (values.empty()) {
+        return 0;
+    }
+
+    if (ring) {
+        // Enfileirar o máximo possível sem acordar ninguém; um único
+        // despertar em lote no final cobre todo o trecho rápido
+        size_t sent = 0;
+        while (sent < values.size() && !closed_flag.load() &&
+               try_ring_send(values[sent])) {
+            ++sent;
+        }
+        if (sent > 0) {
+            wake_receivers(sent);
+        }
+        // Anel cheio (ou corrida com close): resto pelo caminho bloqueante
+        while (sent < values.size()) {
+            if (!send(values[sent])) {
+                break;
+            }
+            ++sent;
+        }
+        return sent;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (closed) {
+        return 0;
+    }
+    for (const Value& value : values) {
+        buffer.push_back(value);
+    }
+    AQUA_STAT_ADD(channel_sends, values.size());
+    for (size_t i = 0; i < values.size() && !recv_waiters.empty(); ++i) {
+        wake_one(recv_waiters);
+    }
+    notify_selects(recv_selects);
+    not_empty.notify_all();
+    return values.size();
+}
+
+size_t Channel::receive_many(std::vector<Value>& out, size_t max_n) {
+    if (max_n == 0) {
+        return 0;
+    }
+
+    if (ring) {
+        size_t got = 0;
+        while (got < max_n) {
+            auto value = try_ring_receive();
+            if (!value) {
+                break;
+            }
+            out.push_back(std::move(*value));
+            ++got;
+        }
+        if (got > 0) {
+            wake_senders(got);
+            return got;
+        }
+        // Anel vazio: bloquear pelo primeiro como receive(), depois drenar
+        auto first = receive();
+        if (!first) {
+            return 0;
+        }
+        out.push_back(std::move(*first));
+        got = 1;
+        while (got < max_n) {
+            auto value = try_ring_receive();
+            if (!value) {
+                break;
+            }
+            out.push_back(std::move(*value));
+            ++got;
+        }
+        if (got > 1) {
+            wake_senders(got - 1); // receive() já acordou um remetente
+        }
+        return got;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (buffer.empty() && !closed) {
+        if (Scheduler::current_fiber()) {
+            block_fiber(lock, recv_waiters);
+        } else {
+            AQUA_STAT_ADD(channel_blocking_waits, 1);
+            not_empty.wait(lock, [this] { return !buffer.empty() || closed; });
+        }
+    }
+    size_t got = 0;
+    while (got < max_n && !buffer.empty()) {
+        out.push_back(std::move(buffer.front()));
+        buffer.pop_front();
+        ++got;
+    }
+    AQUA_STAT_ADD(channel_receives, got);
+    return got;
+}
+
+bool Channel::try_send(const Value& value) {
+    if (ring) {
+        if (closed_flag.load()) {
+            return false;
+        }
+        if (try_ring_send(value)) {
+            wake_receiver();
+            return true;
+        }
+        return false;
+    }
+
+    // Canal sem buffer: a fila é ilimitada, então enviar nunca bloqueia
+    return send(value);
+}
+
+std::optional<Value> Channel::try_receive() {
+    if (ring) {
+        if (auto value = try_ring_receive()) {
+            wake_sender();
+            return value;
+        }
+        return std::nullopt;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (buffer.empty()) {
+        return std::nullopt;
+    }
+    Value value(std::move(buffer.front()));
+    buffer.pop_front();
+    AQUA_STAT_ADD(channel_receives, 1);
+    return value;
+}
+
 std::optional<Value> Channel::receive() {
+    if (ring) {
+        // Caminho rápido: tirar direto do anel, sem lock
+        if (auto value = try_ring_receive()) {
+            wake_sender();
+            return value;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            recv_sleepers.fetch_add(1);
+            if (auto value = try_ring_receive()) {
+                recv_sleepers.fetch_sub(1);
+                lock.unlock();
+                wake_sender();
+                return value;
+            }
+            if (closed_flag.load()) {
+                recv_sleepers.fetch_sub(1);
+                return std::nullopt;
+            }
+            if (Scheduler::current_fiber()) {
+                block_fiber(lock, recv_waiters);
+            } else {
+                AQUA_STAT_ADD(channel_blocking_waits, 1);
+                not_empty.wait(lock);
+            }
+            recv_sleepers.fetch_sub(1);
+        }
+    }
+
     std::unique_lock<std::mutex> lock(mutex);
-    
+
     // Aguardar até que haja dados ou o canal seja fechado
-    not_empty.wait(lock, [this] { return !buffer.empty() || closed; });
-    
+    while (buffer.empty() && !closed) {
+        if (Scheduler::current_fiber()) {
+            block_fiber(lock, recv_waiters);
+        } else {
+            AQUA_STAT_ADD(channel_blocking_waits, 1);
+            not_empty.wait(lock, [this] { return !buffer.empty() || closed; });
+        }
+    }
+
     if (buffer.empty() && closed) {
         return std::nullopt;
     }
-    
-    Value value(buffer.front());
-    buffer.pop();
-    
-    if (max_size > 0) {
-        not_full.notify_one();
-    }
-    
+
+    Value value(std::move(buffer.front()));
+    buffer.pop_front();
+    AQUA_STAT_ADD(channel_receives, 1);
     return value;
 }
 
 void Channel::close() {
+    closed_flag.store(true);
     std::unique_lock<std::mutex> lock(mutex);
     closed = true;
-    not_empty.notify_all();
-    not_full.notify_all();
+    wake_all_locked();
 }
 
 bool Channel::is_closed() const {
+    if (ring) return closed_flag.load();
     std::unique_lock<std::mutex> lock(mutex);
     return closed;
 }
 
 bool Channel::is_empty() const {
-    std::unique_lock<std::mutex> lock(mutex);
-    return buffer.empty();
+    return size() == 0;
 }
 
 bool Channel::is_full() const {
     if (max_size == 0) return false;
-    std::unique_lock<std::mutex> lock(mutex);
-    return buffer.size() >= max_size;
+    return size() >= max_size;
 }
 
 size_t Channel::size() const {
+    if (ring) {
+        size_t enq = enqueue_pos.load(std::memory_order_acquire);
+        size_t deq = dequeue_pos.load(std::memory_order_acquire);
+        return enq > deq ? enq - deq : 0;
+    }
     std::unique_lock<std::mutex> lock(mutex);
     return buffer.size();
 }
 
-size_t Channel::capacity() const {
-    return max_size;
+size_t Channel::capacity() const {
+    return max_size;
+}
+
+// Implementação de select
+SelectCase SelectCase::receive(std::shared_ptr<Channel> channel) {
+    SelectCase c;
+    c.is_receive = true;
+    c.channel = std::move(channel);
+    return c;
+}
+
+SelectCase SelectCase::send(std::shared_ptr<Channel> channel, Value value) {
+    SelectCase c;
+    c.is_receive = false;
+    c.channel = std::move(channel);
+    c.value = std::move(value);
+    return c;
+}
+
+SelectResult Runtime::select(const std::vector<SelectCase>& cases,
+                             int timeout_ms) {
+    SelectResult result;
+    if (cases.empty()) {
+        return result;
+    }
+
+    // Ponto de partida rotativo: não favorecer sempre o primeiro caso
+    static std::atomic<size_t> rotation{0};
+    size_t start = rotation.fetch_add(1, std::memory_order_relaxed);
+
+    auto poll = [&]() -> bool {
+        for (size_t n = 0; n < cases.size(); ++n) {
+            size_t i = (start + n) % cases.size();
+            const SelectCase& c = cases[i];
+            if (!c.channel) {
+                continue;
+            }
+            if (c.is_receive) {
+                if (auto value = c.channel->try_receive()) {
+                    result.index = i;
+                    result.value = std::move(value);
+                    return true;
+                }
+                if (c.channel->is_closed() && c.channel->is_empty()) {
+                    // Canal fechado e drenado: receive está "pronto" com
+                    // nullopt, como em receive()
+                    result.index = i;
+                    result.value = std::nullopt;
+                    return true;
+                }
+            } else {
+                if (c.channel->try_send(c.value)) {
+                    result.index = i;
+                    result.sent = true;
+                    return true;
+                }
+                if (c.channel->is_closed()) {
+                    result.index = i;
+                    result.sent = false;
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    if (poll() || timeout_ms == 0) {
+        return result;
+    }
+
+    Fiber* in_fiber = Scheduler::current_fiber();
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeout_ms);
+
+    auto waiter = std::make_shared<detail::SelectWaiter>();
+    if (in_fiber) {
+        waiter->fiber = Scheduler::current_fiber_handle();
+        // Com prazo, a roda de timers sinaliza o waiter no vencimento
+        if (timeout_ms > 0) {
+            scheduler->schedule_timer(static_cast<uint64_t>(timeout_ms),
+                                      [waiter]() { waiter->notify(); });
+        }
+    }
+    for (const auto& c : cases) {
+        if (c.channel) {
+            c.channel->add_select_waiter(waiter, c.is_receive);
+        }
+    }
+
+    // Registrar e reavaliar em laço: se um canal ficou pronto entre o poll
+    // e a espera, o sinal já registrado evita a perda do despertar
+    for (;;) {
+        if (poll()) {
+            break;
+        }
+        if (timeout_ms > 0 &&
+            std::chrono::steady_clock::now() >= deadline) {
+            break; // prazo vencido
+        }
+        if (in_fiber) {
+            {
+                std::lock_guard<std::mutex> lock(waiter->m);
+                if (waiter->signaled) {
+                    waiter->signaled = false;
+                    continue;
+                }
+            }
+            // Um notify entre a checagem e a suspensão vira wake_pending e
+            // o estacionamento retorna de imediato (ver park_fiber/unpark)
+            Scheduler::suspend_current();
+            std::lock_guard<std::mutex> lock(waiter->m);
+            waiter->signaled = false;
+        } else {
+            std::unique_lock<std::mutex> lock(waiter->m);
+            if (timeout_ms > 0) {
+                if (!waiter->cv.wait_until(lock, deadline,
+                                           [&] { return waiter->signaled; })) {
+                    break; // prazo vencido
+                }
+            } else {
+                waiter->cv.wait(lock, [&] { return waiter->signaled; });
+            }
+            waiter->signaled = false;
+        }
+    }
+
+    for (const auto& c : cases) {
+        if (c.channel) {
+            c.channel->remove_select_waiter(waiter.get(), c.is_receive);
+        }
+    }
+    // Um timer atrasado ainda segura o waiter; sem a fibra, o notify dele
+    // vira um no-op em vez de um despertar espúrio
+    {
+        std::lock_guard<std::mutex> lock(waiter->m);
+        waiter->fiber.reset();
+    }
+    return result;
+}
+
+// Implementação da classe Fiber
+size_t Fiber::next_id = 1;
+
+// Pilha padrão: precisa comportar iostream/strings do código do usuário.
+static constexpr size_t kDefaultStackSize = 256 * 1024;
+
+#if defined(__linux__) || defined(__APPLE__)
+namespace {
+
+// Pilha de fibra vinda do pool: o mapeamento começa numa página de guarda
+// (PROT_NONE) e a área utilizável fica logo acima dela.
+struct PooledStack {
+    void* base{nullptr};
+    size_t usable{0};
+};
+
+// Pool de pilhas por thread. Fibras curtas são criadas e destruídas aos
+// milhares por segundo; reutilizar os mapeamentos evita um mmap/munmap por
+// fibra. Ao devolver uma pilha, madvise(DONTNEED) entrega as páginas
+// físicas ao kernel mas mantém o endereço reservado para a próxima fibra.
+// Estouro de pilha bate na página de guarda e vira SIGSEGV imediato, em vez
+// de corromper memória vizinha.
+class StackPool {
+public:
+    ~StackPool() {
+        for (const auto& entry : free_list) {
+            unmap(entry);
+        }
+    }
+
+    PooledStack acquire(size_t usable) {
+        for (size_t i = 0; i < free_list.size(); ++i) {
+            if (free_list[i].usable == usable) {
+                PooledStack entry = free_list[i];
+                free_list[i] = free_list.back();
+                free_list.pop_back();
+                return entry;
+            }
+        }
+        return map(usable);
+    }
+
+    void release(const PooledStack& entry) {
+        if (free_list.size() >= kMaxFree) {
+            unmap(entry);
+            return;
+        }
+        madvise(static_cast<char*>(entry.base) + page_size(), entry.usable,
+                MADV_DONTNEED);
+        free_list.push_back(entry);
+    }
+
+    static size_t page_size() {
+        static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return page;
+    }
+
+    static size_t round_to_pages(size_t bytes) {
+        size_t page = page_size();
+        return (bytes + page - 1) / page * page;
+    }
+
+private:
+    // Pilhas retidas por thread; o excedente volta para o kernel
+    static constexpr size_t kMaxFree = 32;
+
+    std::vector<PooledStack> free_list;
+
+    static PooledStack map(size_t usable) {
+        size_t page = page_size();
+        void* base = mmap(nullptr, usable + page, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            return {};
+        }
+        // Página de guarda na extremidade baixa: a pilha cresce para baixo
+        mprotect(base, page, PROT_NONE);
+        return {base, usable};
+    }
+
+    static void unmap(const PooledStack& entry) {
+        munmap(entry.base, entry.usable + page_size());
+    }
+};
+
+thread_local StackPool tl_stack_pool;
+
+} // namespace
+#endif
+
+// Pool de objetos Fiber por thread. Além da pilha (ver StackPool), criar
+// uma fibra paga um ucontext no heap e os vetores de locais; reciclar o
+// objeto inteiro reaproveita tudo isso — a reinicialização vira atribuições
+// simples e, quando o tamanho de pilha bate, um makecontext. A devolução
+// acontece no deleter do shared_ptr, ou seja, só quando o último handle
+// (filas, canais, instantâneo do coletor) soltar a fibra.
+class FiberPool {
+public:
+#if defined(__linux__) || defined(__APPLE__)
+    FiberPool() {
+        // Força a construção do pool de pilhas desta thread antes deste:
+        // nosso dtor ainda devolve pilhas a ele (destruição TLS é na ordem
+        // inversa da construção)
+        (void)&tl_stack_pool;
+    }
+#endif
+
+    ~FiberPool() {
+        for (Fiber* fiber : free_list) {
+            delete fiber;
+        }
+    }
+
+    Fiber* acquire(detail::SmallFunc func, size_t stack_size) {
+        if (!free_list.empty()) {
+            Fiber* fiber = free_list.back();
+            free_list.pop_back();
+            fiber->reset_for_reuse(std::move(func), stack_size);
+            return fiber;
+        }
+        return new Fiber(std::move(func), stack_size);
+    }
+
+    void release(Fiber* fiber) {
+        fiber->scrub();
+        if (free_list.size() >= kMaxFree) {
+            delete fiber;
+            return;
+        }
+        free_list.push_back(fiber);
+    }
+
+private:
+    // Fibras retidas por thread; o excedente é destruído normalmente
+    static constexpr size_t kMaxFree = 32;
+
+    std::vector<Fiber*> free_list;
+};
+
+static thread_local FiberPool tl_fiber_pool;
+
+Fiber::Fiber(detail::SmallFunc func, size_t stack_size_hint)
+    : id(next_id++), state(State::READY), function(std::move(func)),
+      context(nullptr), stack(nullptr),
+      stack_size(stack_size_hint == 0 ? kDefaultStackSize : stack_size_hint) {
+    setup_context();
+}
+
+Fiber::~Fiber() {
+    cleanup_context();
+}
+
+void Fiber::trampoline(unsigned int hi, unsigned int lo) {
+    auto ptr = (static_cast<uintptr_t>(hi) << 32) | static_cast<uintptr_t>(lo);
+    reinterpret_cast<Fiber*>(ptr)->run();
+}
+
+void Fiber::run() {
+    try {
+        function();
+        state.store(State::FINISHED);
+    } catch (...) {
+        state.store(State::ERROR);
+    }
+
+    // Devolver o controle definitivamente ao worker; este contexto nunca
+    // mais será retomado.
+    swapcontext(static_cast<ucontext_t*>(context), tl_worker_context);
+}
+
+void Fiber::setup_context() {
+#if defined(__linux__) || defined(__APPLE__)
+    stack_size = StackPool::round_to_pages(stack_size);
+    PooledStack pooled = tl_stack_pool.acquire(stack_size);
+    if (pooled.base) {
+        stack = static_cast<char*>(pooled.base) + StackPool::page_size();
+    }
+    if (stack) {
+        context = new ucontext_t();
+        arm_context();
+    }
+#endif
+}
+
+void Fiber::arm_context() {
+#if defined(__linux__) || defined(__APPLE__)
+    ucontext_t* ctx = static_cast<ucontext_t*>(context);
+    getcontext(ctx);
+    ctx->uc_stack.ss_sp = stack;
+    ctx->uc_stack.ss_size = stack_size;
+    ctx->uc_link = nullptr;
+
+    // makecontext só aceita argumentos int: passar o ponteiro da fibra
+    // dividido em duas metades de 32 bits.
+    auto ptr = reinterpret_cast<uintptr_t>(this);
+    makecontext(ctx, reinterpret_cast<void (*)()>(&Fiber::trampoline), 2,
+                static_cast<unsigned int>(ptr >> 32),
+                static_cast<unsigned int>(ptr & 0xffffffffu));
+#endif
+}
+
+void Fiber::reset_for_reuse(detail::SmallFunc func, size_t stack_size_hint) {
+    id = next_id++;
+    state.store(State::READY);
+    function = std::move(func);
+    suspend_reason = SuspendReason::YIELDED;
+    last_worker = static_cast<size_t>(-1);
+    parked = false;
+    wake_pending = false;
+
+    size_t wanted = stack_size_hint == 0 ? kDefaultStackSize : stack_size_hint;
+#if defined(__linux__) || defined(__APPLE__)
+    wanted = StackPool::round_to_pages(wanted);
+    if (context && stack && stack_size == wanted) {
+        // Pilha e ucontext servem: só rearmar o ponto de entrada
+        arm_context();
+        return;
+    }
+    cleanup_context();
+    stack_size = wanted;
+    setup_context();
+#else
+    stack_size = wanted;
+#endif
+}
+
+void Fiber::scrub() {
+    function.reset();
+    std::lock_guard<std::mutex> lock(locals_mutex);
+    locals.clear();
+    locals_present.clear();
+}
+
+void Fiber::cleanup_context() {
+#if defined(__linux__) || defined(__APPLE__)
+    if (context) {
+        delete static_cast<ucontext_t*>(context);
+        context = nullptr;
+    }
+    if (stack) {
+        tl_stack_pool.release(
+            {static_cast<char*>(stack) - StackPool::page_size(), stack_size});
+        stack = nullptr;
+    }
+#endif
+}
+
+void Fiber::start() {
+    // Compatibilidade: o primeiro resume entra no trampoline
+    resume();
+}
+
+void Fiber::yield() {
+    if (tl_current_fiber == this) {
+        suspend(SuspendReason::YIELDED);
+    }
+}
+
+void Fiber::resume() {
+#if defined(__linux__) || defined(__APPLE__)
+    if (is_finished() || !context) return;
+
+    state.store(State::RUNNING);
+
+    ucontext_t worker_ctx;
+    ucontext_t* prev_context = tl_worker_context;
+    Fiber* prev_fiber = tl_current_fiber;
+    tl_worker_context = &worker_ctx;
+    tl_current_fiber = this;
+
+    // Entra (ou reentra) no contexto da fibra; retorna quando ela suspender
+    // ou terminar.
+    swapcontext(&worker_ctx, static_cast<ucontext_t*>(context));
+
+    tl_worker_context = prev_context;
+    tl_current_fiber = prev_fiber;
+#else
+    // Sem suporte a ucontext: executar até o fim na thread corrente
+    state.store(State::RUNNING);
+    function();
+    state.store(State::FINISHED);
+#endif
+}
+
+void Fiber::wait() {
+    if (tl_current_fiber == this) {
+        suspend(SuspendReason::BLOCKED);
+    }
+}
+
+void Fiber::suspend(SuspendReason reason) {
+#if defined(__linux__) || defined(__APPLE__)
+    suspend_reason = reason;
+    state.store(reason == SuspendReason::YIELDED ? State::READY : State::WAITING);
+    swapcontext(static_cast<ucontext_t*>(context), tl_worker_context);
+    state.store(State::RUNNING);
+#else
+    (void)reason;
+#endif
+}
+
+void Fiber::finish() {
+    state.store(State::FINISHED);
+}
+
+Fiber::State Fiber::get_state() const {
+    return state.load();
+}
+
+size_t Fiber::get_id() const {
+    return id;
+}
+
+bool Fiber::is_finished() const {
+    State s = state.load();
+    return s == State::FINISHED || s == State::ERROR;
+}
+
+void Fiber::set_local(LocalKey key, const Value& value) {
+    set_local(key, Value(value));
+}
+
+void Fiber::set_local(LocalKey key, Value&& value) {
+    std::lock_guard<std::mutex> lock(locals_mutex);
+    if (key >= locals.size()) {
+        locals.resize(key + 1);
+        locals_present.resize(key + 1, false);
+    }
+    locals[key] = std::move(value);
+    locals_present[key] = true;
+}
+
+std::optional<Value> Fiber::get_local(LocalKey key) const {
+    std::lock_guard<std::mutex> lock(locals_mutex);
+    if (key < locals.size() && locals_present[key]) {
+        return locals[key];
+    }
+    return std::nullopt;
+}
+
+void Fiber::set_local(const std::string& key, const Value& value) {
+    set_local(Runtime::get_instance().local_key(key), Value(value));
+}
+
+void Fiber::set_local(const std::string& key, Value&& value) {
+    set_local(Runtime::get_instance().local_key(key), std::move(value));
+}
+
+std::optional<Value> Fiber::get_local(const std::string& key) const {
+    return get_local(Runtime::get_instance().local_key(key));
+}
+
+// Implementação do deque de roubo de trabalho (Chase-Lev)
+bool Scheduler::WorkStealingDeque::push(Fiber* fiber) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= static_cast<int64_t>(kCapacity)) {
+        return false; // cheio: chamador transborda para a fila externa
+    }
+    buffer[static_cast<size_t>(b) & kMask].store(fiber, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Fiber* Scheduler::WorkStealingDeque::pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // Vazio
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Fiber* fiber = buffer[static_cast<size_t>(b) & kMask].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Último elemento: disputa com ladrões via CAS no topo
+        if (!top.compare_exchange_strong(t, t + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            fiber = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return fiber;
+}
+
+Fiber* Scheduler::WorkStealingDeque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+
+    Fiber* fiber = buffer[static_cast<size_t>(t) & kMask].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1,
+                                     std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+        return nullptr; // perdeu a corrida
+    }
+    return fiber;
+}
+
+size_t Scheduler::WorkStealingDeque::size() const {
+    // Leitura relaxed de dois contadores que andam por conta própria: o
+    // resultado é uma aproximação, suficiente para diagnóstico
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_relaxed);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+}
+
+// Implementação da roda de timers
+void Scheduler::TimerWheel::start() {
+    std::lock_guard<std::mutex> lock(m);
+    if (running) return;
+    running = true;
+    epoch = std::chrono::steady_clock::now();
+    current_tick = 0;
+    thread = std::thread(&TimerWheel::run, this);
+}
+
+void Scheduler::TimerWheel::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (!running) return;
+        running = false;
+        // Despertares pendentes são descartados: quem parou o agendador
+        // não espera mais pelas fibras adormecidas
+        for (auto& level : slots) {
+            for (auto& bucket : level) {
+                bucket.clear();
+            }
+        }
+        armed = 0;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void Scheduler::TimerWheel::schedule(uint64_t delay_ms,
+                                     std::function<void()> wake) {
+    {
+        std::unique_lock<std::mutex> lock(m);
+        if (running) {
+            auto now = std::chrono::steady_clock::now();
+            uint64_t now_tick = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    now - epoch).count());
+            // Com a roda ociosa o tique corrente fica para trás; saltar
+            // direto evita avançar milhares de tiques vazios depois
+            if (armed == 0 && now_tick > current_tick) {
+                current_tick = now_tick;
+            }
+            insert_locked({now_tick + (delay_ms == 0 ? 1 : delay_ms),
+                           std::move(wake)});
+            cv.notify_one();
+            return;
+        }
+    }
+    // Roda parada: disparar já em vez de perder o despertar
+    wake();
+}
+
+void Scheduler::TimerWheel::insert_locked(Timer timer) {
+    if (timer.deadline <= current_tick) {
+        timer.deadline = current_tick + 1;
+    }
+    uint64_t delta = timer.deadline - current_tick;
+    size_t level = 0;
+    while (level + 1 < kLevels &&
+           delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+    size_t slot = (timer.deadline >> (kSlotBits * level)) & kSlotMask;
+    slots[level][slot].push_back(std::move(timer));
+    ++armed;
+}
+
+void Scheduler::TimerWheel::advance_locked(uint64_t target,
+                                           std::vector<Timer>& due) {
+    while (current_tick < target) {
+        if (armed == 0) {
+            current_tick = target;
+            return;
+        }
+        ++current_tick;
+
+        // Quando os bits inferiores zeram, o slot do nível acima vence:
+        // redistribuir seus timers para os níveis de baixo
+        for (size_t level = 1; level < kLevels; ++level) {
+            if ((current_tick &
+                 ((uint64_t(1) << (kSlotBits * level)) - 1)) != 0) {
+                break;
+            }
+            auto& bucket =
+                slots[level][(current_tick >> (kSlotBits * level)) & kSlotMask];
+            std::vector<Timer> pending = std::move(bucket);
+            bucket.clear();
+            armed -= pending.size();
+            for (auto& timer : pending) {
+                insert_locked(std::move(timer));
+            }
+        }
+
+        auto& bucket = slots[0][current_tick & kSlotMask];
+        for (auto& timer : bucket) {
+            due.push_back(std::move(timer));
+        }
+        armed -= bucket.size();
+        bucket.clear();
+    }
+}
+
+void Scheduler::TimerWheel::run() {
+    std::unique_lock<std::mutex> lock(m);
+    while (running) {
+        if (armed == 0) {
+            cv.wait(lock, [this] { return !running || armed > 0; });
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        uint64_t now_tick = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - epoch).count());
+
+        std::vector<Timer> due;
+        advance_locked(now_tick, due);
+        if (!due.empty()) {
+            // Disparar fora do lock: o despertar reenfileira fibras e pode
+            // tocar mutexes do agendador
+            lock.unlock();
+            for (auto& timer : due) {
+                timer.wake();
+            }
+            lock.lock();
+            continue;
+        }
+
+        cv.wait_until(lock,
+                      epoch + std::chrono::milliseconds(current_tick + 1));
+    }
+}
+
+// Implementação da classe Scheduler
+Scheduler::Scheduler(size_t num_threads)
+    : Scheduler(SchedulerOptions{num_threads == 0 ? 1 : num_threads,
+                                 false, {}}) {
+}
+
+Scheduler::Scheduler(const SchedulerOptions& opts)
+    : options(opts), running(false) {
+    size_t wanted = options.num_workers == 0
+                        ? std::thread::hardware_concurrency()
+                        : options.num_workers;
+    num_workers = wanted == 0 ? 1 : wanted;
+    workers.reserve(num_workers);
+    local_queues.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        local_queues.push_back(std::make_unique<WorkStealingDeque>());
+    }
+    affinity_queues.resize(num_workers);
+}
+
+Scheduler::~Scheduler() {
+    stop();
+}
+
+void Scheduler::start() {
+    if (running) return;
+
+    running = true;
+    timer_wheel.start();
+
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&Scheduler::worker_loop, this, i);
+    }
+}
+
+void Scheduler::stop() {
+    if (!running) return;
+
+    running = false;
+    timer_wheel.stop();
+    worker_condition.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+    drain_queues();
+}
+
+void Scheduler::spawn(detail::SmallFunc func, size_t stack_size) {
+    // Fibra do pool da thread corrente; o deleter devolve o objeto ao pool
+    // de quem soltar o último handle em vez de destruí-lo
+    std::shared_ptr<Fiber> fiber(
+        tl_fiber_pool.acquire(std::move(func), stack_size),
+        [](Fiber* f) { tl_fiber_pool.release(f); });
+    fiber->self_ref = fiber;
+    {
+        std::lock_guard<std::mutex> lock(fibers_mutex);
+        live_fibers.insert(fiber.get());
+    }
+    outstanding_fibers.fetch_add(1);
+    schedule_fiber(fiber.get());
+}
+
+void Scheduler::yield() {
+    if (tl_current_fiber) {
+        tl_current_fiber->suspend(Fiber::SuspendReason::YIELDED);
+    }
+}
+
+void Scheduler::sleep_current(int milliseconds) {
+    if (milliseconds <= 0) {
+        yield();
+        return;
+    }
+
+    if (!tl_current_fiber) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+        return;
+    }
+
+    // Suspender só a fibra: a roda de timers a reenfileira no vencimento.
+    // O laço tolera despertares espúrios (ex.: um timer de select atrasado)
+    auto handle = current_fiber_handle();
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(milliseconds);
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - now).count() + 1;
+        schedule_timer(static_cast<uint64_t>(remaining),
+                       [this, handle]() { unpark(handle); });
+        suspend_current();
+    }
+}
+
+void Scheduler::schedule_timer(uint64_t delay_ms, std::function<void()> wake) {
+    timer_wheel.schedule(delay_ms, std::move(wake));
+}
+
+void Scheduler::wait_all() {
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    wait_condition.wait(lock, [this] { return outstanding_fibers.load() == 0; });
 }
 
-// Implementação da classe Fiber
-size_t Fiber::next_id = 1;
+bool Scheduler::is_running() const {
+    return running;
+}
 
-Fiber::Fiber(std::function<void()> func) 
-    : id(next_id++), state(State::READY), function(std::move(func)), 
-      context(nullptr), stack(nullptr), stack_size(8192) {
-    setup_context();
+size_t Scheduler::active_fibers() const {
+    return running_count.load();
 }
 
-Fiber::~Fiber() {
-    cleanup_context();
+size_t Scheduler::total_fibers() const {
+    return outstanding_fibers.load();
 }
 
-void Fiber::setup_context() {
+void Scheduler::worker_loop(size_t worker_index) {
+    tl_worker_scheduler = this;
+    tl_worker_index = worker_index;
+
 #ifdef __linux__
-    stack = malloc(stack_size);
-    if (stack) {
-        ucontext_t* ctx = new ucontext_t();
-        getcontext(ctx);
-        ctx->uc_stack.ss_sp = stack;
-        ctx->uc_stack.ss_size = stack_size;
-        ctx->uc_link = nullptr;
-        
-        // Por enquanto, não usamos makecontext devido à complexidade
-        // com lambdas. Em uma implementação real, seria necessário
-        // um sistema mais sofisticado de gerenciamento de contexto.
-        context = ctx;
+    if (options.pin_workers) {
+        unsigned int ncpus = std::thread::hardware_concurrency();
+        int cpu = options.cpus.empty()
+                      ? static_cast<int>(worker_index %
+                                         (ncpus == 0 ? 1 : ncpus))
+                      : options.cpus[worker_index % options.cpus.size()];
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
     }
 #endif
-}
 
-void Fiber::cleanup_context() {
-#ifdef __linux__
-    if (context) {
-        delete static_cast<ucontext_t*>(context);
-        context = nullptr;
-    }
-    if (stack) {
-        free(stack);
-        stack = nullptr;
+    while (running) {
+        Fiber* fiber = get_next_fiber(worker_index);
+        if (!fiber) {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            worker_condition.wait_for(lock, std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // Cópia local da auto-referência mantém a fibra viva até o fim da
+        // iteração mesmo que ela termine durante o resume
+        auto handle = fiber->self_ref;
+        tl_current_handle = handle;
+        fiber->last_worker = worker_index;
+        running_count.fetch_add(1);
+        fiber->resume();
+        running_count.fetch_sub(1);
+        tl_current_handle.reset();
+
+        if (fiber->is_finished()) {
+            AQUA_STAT_ADD(fibers_executed, 1);
+            {
+                std::lock_guard<std::mutex> lock(fibers_mutex);
+                live_fibers.erase(fiber);
+                fiber->self_ref.reset();
+            }
+            // A última fibra acorda quem espera em wait_all; o lock fecha a
+            // corrida com o predicado do wait
+            if (outstanding_fibers.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(wait_mutex);
+                wait_condition.notify_all();
+            }
+        } else if (fiber->suspend_reason == Fiber::SuspendReason::YIELDED) {
+            schedule_fiber(fiber);
+        } else {
+            park_fiber(fiber);
+        }
+
+        // Fatia incremental de marcação do coletor entre trocas de fibra:
+        // no-op quando não há ciclo em andamento
+        Runtime::get_instance().get_gc().collect_step();
     }
-#endif
+
+    tl_worker_scheduler = nullptr;
 }
 
-void Fiber::start() {
-    if (state == State::READY) {
-        state = State::RUNNING;
-        // Aqui seria feita a troca de contexto real
-        function();
-        state = State::FINISHED;
+void Scheduler::schedule_fiber(Fiber* fiber) {
+    // Num worker deste agendador: push local sem lock; a fila externa só
+    // recebe transbordo e spawns de outras threads
+    if (tl_worker_scheduler == this &&
+        local_queues[tl_worker_index]->push(fiber)) {
+        worker_condition.notify_one();
+        return;
     }
-}
 
-void Fiber::yield() {
-    if (state == State::RUNNING) {
-        state = State::READY;
-        // Troca de contexto para o scheduler
+    {
+        // Despertares vindos de fora dos workers (timers, reator de E/S,
+        // outro agendador): de volta à caixa do último worker da fibra,
+        // que a retoma com cache e nó de memória ainda quentes
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (fiber->last_worker < num_workers) {
+            affinity_queues[fiber->last_worker].push(fiber);
+        } else {
+            ready_queue.push(fiber);
+        }
     }
+    worker_condition.notify_one();
 }
 
-void Fiber::resume() {
-    if (state == State::READY) {
-        state = State::RUNNING;
-        // Troca de contexto para esta fibra
+Fiber* Scheduler::pop_external(size_t worker_index) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    auto& mine = affinity_queues[worker_index];
+    if (!mine.empty()) {
+        Fiber* fiber = mine.front();
+        mine.pop();
+        return fiber;
+    }
+    if (ready_queue.empty()) {
+        return nullptr;
     }
+    Fiber* fiber = ready_queue.front();
+    ready_queue.pop();
+    return fiber;
 }
 
-void Fiber::wait() {
-    if (state == State::RUNNING) {
-        state = State::WAITING;
-        // Troca de contexto para o scheduler
+Fiber* Scheduler::get_next_fiber(size_t worker_index) {
+    // 1) Fila local (sem contenção)
+    if (Fiber* fiber = local_queues[worker_index]->pop()) {
+        return fiber;
     }
-}
 
-void Fiber::finish() {
-    state = State::FINISHED;
-}
+    // 2) Caixa de afinidade deste worker e fila externa
+    if (Fiber* fiber = pop_external(worker_index)) {
+        return fiber;
+    }
 
-Fiber::State Fiber::get_state() const {
-    return state;
-}
+    // 3) Roubar do topo das filas dos outros workers
+    for (size_t i = 1; i < num_workers; ++i) {
+        size_t victim = (worker_index + i) % num_workers;
+        if (Fiber* fiber = local_queues[victim]->steal()) {
+            AQUA_STAT_ADD(steals, 1);
+            return fiber;
+        }
+    }
 
-size_t Fiber::get_id() const {
-    return id;
+    // 4) Caixas de afinidade dos outros workers: a preferência de
+    // localidade cede antes de deixar um worker parado (e evita fibras
+    // presas atrás de um worker ocupado)
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        for (size_t i = 1; i < num_workers; ++i) {
+            auto& box = affinity_queues[(worker_index + i) % num_workers];
+            if (!box.empty()) {
+                Fiber* fiber = box.front();
+                box.pop();
+                return fiber;
+            }
+        }
+    }
+
+    return nullptr;
 }
 
-bool Fiber::is_finished() const {
-    return state == State::FINISHED || state == State::ERROR;
+void Scheduler::park_fiber(Fiber* fiber) {
+    std::unique_lock<std::mutex> lock(fiber->wake_mutex);
+    if (fiber->wake_pending) {
+        // Alguém já pediu para acordar antes de estacionarmos
+        fiber->wake_pending = false;
+        lock.unlock();
+        schedule_fiber(fiber);
+    } else {
+        fiber->parked = true;
+    }
 }
 
-void Fiber::set_local(const std::string& key, const Value& value) {
-    locals[key] = value;
+void Scheduler::unpark(const std::shared_ptr<Fiber>& fiber) {
+    std::unique_lock<std::mutex> lock(fiber->wake_mutex);
+    if (fiber->parked) {
+        fiber->parked = false;
+        lock.unlock();
+        schedule_fiber(fiber.get());
+    } else {
+        // A fibra ainda não salvou o contexto; o worker reenfileira ao
+        // estacionar (ver park_fiber)
+        fiber->wake_pending = true;
+    }
 }
 
-std::optional<Value> Fiber::get_local(const std::string& key) const {
-    auto it = locals.find(key);
-    if (it != locals.end()) {
-        return it->second;
+void Scheduler::drain_queues() {
+    // Desfazer as auto-referências das fibras que nunca chegaram a rodar,
+    // para não vazar seus ciclos de shared_ptr
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    std::lock_guard<std::mutex> fibers_lock(fibers_mutex);
+    while (!ready_queue.empty()) {
+        Fiber* fiber = ready_queue.front();
+        ready_queue.pop();
+        live_fibers.erase(fiber);
+        fiber->self_ref.reset();
+    }
+    for (auto& box : affinity_queues) {
+        while (!box.empty()) {
+            Fiber* fiber = box.front();
+            box.pop();
+            live_fibers.erase(fiber);
+            fiber->self_ref.reset();
+        }
+    }
+    for (auto& queue : local_queues) {
+        while (Fiber* fiber = queue->steal()) {
+            live_fibers.erase(fiber);
+            fiber->self_ref.reset();
+        }
     }
-    return std::nullopt;
 }
 
-// Implementação da classe Scheduler
-Scheduler::Scheduler(size_t num_threads) : running(false) {
-    workers.reserve(num_threads);
+std::vector<std::shared_ptr<Fiber>> Scheduler::snapshot_fibers() const {
+    std::lock_guard<std::mutex> lock(fibers_mutex);
+    std::vector<std::shared_ptr<Fiber>> fibers;
+    fibers.reserve(live_fibers.size());
+    for (Fiber* fiber : live_fibers) {
+        if (auto handle = fiber->self_ref) {
+            fibers.push_back(std::move(handle));
+        }
+    }
+    return fibers;
 }
 
-Scheduler::~Scheduler() {
-    stop();
+Fiber* Scheduler::current_fiber() {
+    return tl_current_fiber;
 }
 
-void Scheduler::start() {
-    if (running) return;
-    
-    running = true;
-    
-    for (size_t i = 0; i < workers.capacity(); ++i) {
-        workers.emplace_back(&Scheduler::worker_loop, this);
-    }
+std::shared_ptr<Fiber> Scheduler::current_fiber_handle() {
+    return tl_current_handle;
 }
 
-void Scheduler::stop() {
-    if (!running) return;
-    
-    running = false;
-    worker_condition.notify_all();
-    
-    for (auto& worker : workers) {
-        if (worker.joinable()) {
-            worker.join();
-        }
+void Scheduler::suspend_current() {
+    if (tl_current_fiber) {
+        tl_current_fiber->suspend(Fiber::SuspendReason::BLOCKED);
     }
-    workers.clear();
 }
 
-void Scheduler::spawn(std::function<void()> func) {
-    auto fiber = std::make_shared<Fiber>(std::move(func));
-    
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    ready_queue.push(fiber);
-    worker_condition.notify_one();
+// Implementação da classe WaitGroup
+void WaitGroup::add(size_t n) {
+    count.fetch_add(static_cast<int64_t>(n));
 }
 
-void Scheduler::yield() {
-    // Implementação simplificada - em uma implementação real,
-    // isso seria chamado pelo sistema de fibras
+void WaitGroup::done() {
+    if (count.fetch_sub(1) == 1) {
+        std::vector<std::shared_ptr<Fiber>> fibers;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            fibers.swap(waiting_fibers);
+        }
+        cv.notify_all();
+        if (!fibers.empty()) {
+            auto& scheduler = Runtime::get_instance().get_scheduler();
+            for (auto& fiber : fibers) {
+                scheduler.unpark(fiber);
+            }
+        }
+    }
 }
 
-void Scheduler::wait_all() {
-    while (true) {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        if (ready_queue.empty() && running_fibers.empty() && waiting_fibers.empty()) {
-            break;
+void WaitGroup::wait() {
+    if (Scheduler::current_fiber()) {
+        auto handle = Scheduler::current_fiber_handle();
+        for (;;) {
+            {
+                // Checar e registrar sob o mesmo lock: ou o done vê o
+                // handle na lista, ou nós vemos o contador zerado
+                std::lock_guard<std::mutex> lock(m);
+                if (count.load() <= 0) {
+                    return;
+                }
+                waiting_fibers.push_back(handle);
+            }
+            Scheduler::suspend_current();
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
-}
 
-bool Scheduler::is_running() const {
-    return running;
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [this] { return count.load() <= 0; });
 }
 
-size_t Scheduler::active_fibers() const {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    return running_fibers.size();
+#ifdef __linux__
+// Implementação da classe IoReactor
+IoReactor::IoReactor() = default;
+
+IoReactor::~IoReactor() {
+    stop();
 }
 
-size_t Scheduler::total_fibers() const {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    return ready_queue.size() + running_fibers.size() + waiting_fibers.size();
+void IoReactor::start() {
+    if (running.load()) {
+        return;
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wake_fd < 0) {
+        // Sem reator as esperas degradam para poll() bloqueante
+        if (epoll_fd >= 0) { close(epoll_fd); epoll_fd = -1; }
+        if (wake_fd >= 0) { close(wake_fd); wake_fd = -1; }
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+    running.store(true);
+    thread = std::thread(&IoReactor::run, this);
 }
 
-void Scheduler::worker_loop() {
-    while (running) {
-        auto fiber = get_next_fiber();
-        if (fiber) {
-            if (fiber->get_state() == Fiber::State::READY) {
-                fiber->start();
+void IoReactor::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    uint64_t one = 1;
+    if (::write(wake_fd, &one, sizeof(one)) < 0) {
+        // Melhor esforço: epoll_wait também retorna quando o fd fechar
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    // Acorda quem ainda esperava: a fibra tenta a operação de novo e, com
+    // o reator parado, cai na espera bloqueante por poll()
+    std::vector<Waiter> leftover;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        for (auto& entry : waiters) {
+            for (auto& waiter : entry.second) {
+                leftover.push_back(std::move(waiter));
             }
-        } else {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            worker_condition.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        waiters.clear();
+    }
+    for (auto& waiter : leftover) {
+        Runtime::get_instance().get_scheduler().unpark(waiter.fiber);
+    }
+    close(epoll_fd);
+    epoll_fd = -1;
+    close(wake_fd);
+    wake_fd = -1;
+}
+
+void IoReactor::wait_readable(int fd) {
+    wait_event(fd, false);
+}
+
+void IoReactor::wait_writable(int fd) {
+    wait_event(fd, true);
+}
+
+void IoReactor::wait_event(int fd, bool for_write) {
+    if (Scheduler::current_fiber() != nullptr) {
+        bool registered = false;
+        {
+            // Checar `running` sob o mesmo lock que stop() usa para drenar
+            // os esperantes: ou o stop nos vê e desperta, ou nós vemos o
+            // reator parado e caímos no poll()
+            std::lock_guard<std::mutex> lock(m);
+            if (running.load()) {
+                auto& list = waiters[fd];
+                bool already_armed = !list.empty();
+                list.push_back(Waiter{for_write,
+                                      Scheduler::current_fiber_handle()});
+                arm_locked(fd, already_armed);
+                registered = true;
+            }
+        }
+        if (registered) {
+            Scheduler::suspend_current();
+            return;
         }
     }
-}
 
-void Scheduler::schedule_fiber(std::shared_ptr<Fiber> fiber) {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    ready_queue.push(fiber);
+    pollfd p{};
+    p.fd = fd;
+    p.events = for_write ? POLLOUT : POLLIN;
+    ::poll(&p, 1, -1);
 }
 
-std::shared_ptr<Fiber> Scheduler::get_next_fiber() {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    if (ready_queue.empty()) {
-        return nullptr;
+void IoReactor::arm_locked(int fd, bool already_armed) {
+    uint32_t events = 0;
+    for (const auto& waiter : waiters[fd]) {
+        events |= waiter.for_write ? EPOLLOUT : EPOLLIN;
     }
-    
-    auto fiber = ready_queue.front();
-    ready_queue.pop();
-    
-    if (fiber->get_state() == Fiber::State::READY) {
-        running_fibers.push_back(fiber);
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    epoll_ctl(epoll_fd, already_armed ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd,
+              &ev);
+}
+
+void IoReactor::run() {
+    std::array<epoll_event, 64> events;
+    while (running.load()) {
+        int n = epoll_wait(epoll_fd, events.data(),
+                           static_cast<int>(events.size()), -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd) {
+                uint64_t drained;
+                while (::read(wake_fd, &drained, sizeof(drained)) > 0) {
+                }
+                continue;
+            }
+
+            // Qualquer evento (incluindo erro/hangup) acorda todos os que
+            // esperavam por este fd: a própria operação descobre o que
+            // houve ao tentar de novo. O fd sai do epoll até alguém voltar
+            // a esperar, então não há tempestade de despertares.
+            std::vector<Waiter> ready;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                auto it = waiters.find(fd);
+                if (it != waiters.end()) {
+                    ready = std::move(it->second);
+                    waiters.erase(it);
+                }
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            }
+            for (auto& waiter : ready) {
+                Runtime::get_instance().get_scheduler().unpark(waiter.fiber);
+            }
+        }
     }
-    
-    return fiber;
 }
+#endif // __linux__
 
 // Implementação da classe GarbageCollector
-GarbageCollector::GarbageCollector() 
+GarbageCollector::GarbageCollector()
     : memory_threshold(1024 * 1024), total_allocated(0) {
 }
 
-GarbageCollector::~GarbageCollector() = default;
-
 void GarbageCollector::register_object(void* ptr, size_t size) {
     std::lock_guard<std::mutex> lock(gc_mutex);
-    objects[ptr] = {ptr, size, false};
+    objects[ptr] = {ptr, size, false, false, false};
     total_allocated += size;
-    
-    if (total_allocated > memory_threshold) {
-        collect();
+    AQUA_STAT_ADD(gc_bytes_allocated, size);
+
+    // Acima do limiar, iniciar um ciclo e pagar só uma fatia aqui; os
+    // workers levam o resto da marcação adiante entre trocas de fibra
+    if (total_allocated > memory_threshold && phase == Phase::IDLE) {
+        begin_cycle_locked();
+        step_locked(kDefaultSliceBudget);
+    }
+}
+
+// Blocos TLAB: cada thread esculpe objetos de um bloco próprio com um
+// simples avanço de ponteiro; só a troca de bloco toca o gc_mutex. O bloco
+// inteiro é registrado no coletor como um único objeto.
+namespace {
+
+constexpr size_t kTlabBlockSize = 64 * 1024;
+constexpr size_t kTlabAlign = alignof(std::max_align_t);
+
+// Objetos maiores que isso não valem um bloco: vão pelo caminho lento
+constexpr size_t kTlabMaxObject = kTlabBlockSize / 4;
+
+struct Tlab {
+    GarbageCollector* owner{nullptr};
+    char* block_base{nullptr};
+    char* cursor{nullptr};
+    char* limit{nullptr};
+};
+
+thread_local Tlab tl_tlab;
+
+} // namespace
+
+void* GarbageCollector::gc_alloc(size_t size) {
+    size = (size + kTlabAlign - 1) & ~(kTlabAlign - 1);
+
+    if (size > kTlabMaxObject) {
+        void* ptr = ::operator new(size);
+        std::lock_guard<std::mutex> lock(gc_mutex);
+        objects[ptr] = {ptr, size, false, true, false};
+        total_allocated += size;
+        AQUA_STAT_ADD(gc_bytes_allocated, size);
+        return ptr;
+    }
+
+    Tlab& tlab = tl_tlab;
+    if (tlab.owner != this ||
+        static_cast<size_t>(tlab.limit - tlab.cursor) < size) {
+        // Bloco esgotado (ou de outro coletor): esculpir um novo. O bloco
+        // corrente fica fixado (a varredura nunca o libera); o anterior é
+        // desafixado e passa a viver ou morrer pela alcançabilidade.
+        char* block = static_cast<char*>(::operator new(kTlabBlockSize));
+        {
+            std::lock_guard<std::mutex> lock(gc_mutex);
+            objects[block] = {block, kTlabBlockSize, false, true, true};
+            total_allocated += kTlabBlockSize;
+            AQUA_STAT_ADD(gc_bytes_allocated, kTlabBlockSize);
+            if (tlab.owner == this && tlab.block_base) {
+                auto it = objects.find(tlab.block_base);
+                if (it != objects.end()) {
+                    it->second.pinned = false;
+                }
+            }
+        }
+        tlab.owner = this;
+        tlab.block_base = block;
+        tlab.cursor = block;
+        tlab.limit = block + kTlabBlockSize;
     }
+
+    void* ptr = tlab.cursor;
+    tlab.cursor += size;
+    return ptr;
 }
 
 void GarbageCollector::unregister_object(void* ptr) {
@@ -341,13 +1919,41 @@ void GarbageCollector::unregister_object(void* ptr) {
     auto it = objects.find(ptr);
     if (it != objects.end()) {
         total_allocated -= it->second.size;
+        AQUA_STAT_ADD(gc_bytes_freed, it->second.size);
         objects.erase(it);
     }
 }
 
+GarbageCollector::~GarbageCollector() {
+    // Liberar a memória que o coletor possui (blocos TLAB e objetos
+    // grandes de gc_alloc); o TLAB desta thread fica órfão sem o dono
+    if (tl_tlab.owner == this) {
+        tl_tlab = Tlab{};
+    }
+    for (auto& [ptr, info] : objects) {
+        if (info.owned) {
+            ::operator delete(ptr);
+        }
+    }
+}
+
 void GarbageCollector::collect() {
     std::lock_guard<std::mutex> lock(gc_mutex);
-    mark_and_sweep();
+    ScopedGcPause pause;
+    if (phase == Phase::IDLE) {
+        begin_cycle_locked();
+    }
+    while (!step_locked(kDefaultSliceBudget)) {
+    }
+}
+
+bool GarbageCollector::collect_step(size_t budget) {
+    std::lock_guard<std::mutex> lock(gc_mutex);
+    if (phase == Phase::IDLE) {
+        return true;
+    }
+    ScopedGcPause pause;
+    return step_locked(budget);
 }
 
 void GarbageCollector::set_threshold(size_t threshold) {
@@ -368,27 +1974,115 @@ size_t GarbageCollector::total_memory() const {
     return total_allocated;
 }
 
-void GarbageCollector::mark_and_sweep() {
-    // Resetar marcação
+void GarbageCollector::begin_cycle_locked() {
+    // Blocos TLAB ativos já nascem marcados: uma thread pode estar com o
+    // cursor dentro deles neste exato momento
     for (auto& [ptr, info] : objects) {
-        info.marked = false;
+        info.marked = info.pinned;
     }
-    
-    // Marcar objetos alcançáveis (simplificado)
-    mark_reachable_objects();
-    
-    // Remover objetos não marcados
-    sweep_unreachable_objects();
+
+    Runtime& runtime = Runtime::get_instance();
+
+    // Raízes: globais da runtime (o instantâneo é imutável; basta o load)
+    if (auto snapshot = std::atomic_load_explicit(
+            &runtime.globals_snapshot, std::memory_order_acquire)) {
+        for (const auto& [name, value] : *snapshot) {
+            pending_roots.push_back(value);
+        }
+    }
+
+    // …e os locais de cada fibra viva. Os handles fortes impedem que uma
+    // fibra morra entre o instantâneo e a visita.
+    for (const auto& fiber : runtime.get_scheduler().snapshot_fibers()) {
+        std::lock_guard<std::mutex> lock(fiber->locals_mutex);
+        for (size_t i = 0; i < fiber->locals.size(); ++i) {
+            if (fiber->locals_present[i]) {
+                pending_roots.push_back(fiber->locals[i]);
+            }
+        }
+    }
+
+    phase = Phase::MARKING;
 }
 
-void GarbageCollector::mark_reachable_objects() {
-    // Implementação simplificada - em uma implementação real,
-    // isso rastrearia referências ativas na runtime
-    for (auto& [ptr, info] : objects) {
-        // Por enquanto, marcar todos como alcançáveis
-        // Em uma implementação real, isso seria baseado no grafo de referências
-        info.marked = true;
+bool GarbageCollector::step_locked(size_t budget) {
+    while (budget > 0) {
+        if (!pending_roots.empty()) {
+            Value value = std::move(pending_roots.back());
+            pending_roots.pop_back();
+            mark_value(value);
+            --budget;
+            continue;
+        }
+        if (!gray_channels.empty()) {
+            auto channel = std::move(gray_channels.back());
+            gray_channels.pop_back();
+            size_t visited = scan_channel(channel);
+            budget = visited >= budget ? 0 : budget - visited;
+            continue;
+        }
+        // Marcação terminou: varrer e encerrar o ciclo
+        sweep_unreachable_objects();
+        seen_channels.clear();
+        phase = Phase::IDLE;
+        return true;
+    }
+    return false;
+}
+
+void GarbageCollector::mark_value(const Value& value) {
+    // Células refcontadas (strings, canais) não pertencem ao coletor;
+    // mark_address só encontra algo quando o ponteiro cai dentro de um
+    // objeto registrado
+    if (detail::RefCell* cell = value.heap_cell()) {
+        mark_address(cell);
+    }
+    if (auto channel = value.channel_ref()) {
+        if (seen_channels.insert(channel.get()).second) {
+            gray_channels.push_back(std::move(channel));
+        }
+    }
+}
+
+void GarbageCollector::mark_address(const void* ptr) {
+    if (!ptr || objects.empty()) {
+        return;
+    }
+    auto it = objects.upper_bound(const_cast<void*>(ptr));
+    if (it == objects.begin()) {
+        return;
+    }
+    --it;
+    const char* base = static_cast<const char*>(it->first);
+    if (static_cast<const char*>(ptr) < base + it->second.size) {
+        it->second.marked = true;
+    }
+}
+
+size_t GarbageCollector::scan_channel(const std::shared_ptr<Channel>& channel) {
+    std::lock_guard<std::mutex> lock(channel->mutex);
+    size_t visited = 1;
+    if (channel->ring) {
+        size_t deq = channel->dequeue_pos.load(std::memory_order_acquire);
+        size_t enq = channel->enqueue_pos.load(std::memory_order_acquire);
+        for (size_t pos = deq; pos < enq; ++pos) {
+            Channel::RingSlot& slot = channel->ring[pos % channel->max_size];
+            if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+                continue; // slot em trânsito no caminho rápido sem lock
+            }
+            // Se um receive concorrente reivindicar o slot no meio da
+            // visita, o valor continua vivo na mão de quem recebeu e será
+            // alcançado por outra raiz no próximo ciclo
+            mark_value(slot.value);
+            ++visited;
+        }
+    } else {
+        for (const Value& value : channel->buffer) {
+            mark_value(value);
+            ++visited;
+        }
     }
+    return visited;
 }
 
 void GarbageCollector::sweep_unreachable_objects() {
@@ -396,6 +2090,10 @@ void GarbageCollector::sweep_unreachable_objects() {
     while (it != objects.end()) {
         if (!it->second.marked) {
             total_allocated -= it->second.size;
+            AQUA_STAT_ADD(gc_bytes_freed, it->second.size);
+            if (it->second.owned) {
+                ::operator delete(it->second.ptr);
+            }
             it = objects.erase(it);
         } else {
             ++it;
@@ -409,6 +2107,9 @@ Runtime* Runtime::instance = nullptr;
 Runtime::Runtime() {
     scheduler = std::make_unique<Scheduler>();
     gc = std::make_unique<GarbageCollector>();
+#ifdef __linux__
+    io_reactor = std::make_unique<IoReactor>();
+#endif
     instance = this;
 }
 
@@ -419,9 +2120,19 @@ Runtime::~Runtime() {
 
 void Runtime::initialize() {
     scheduler->start();
+#ifdef __linux__
+    io_reactor->start();
+#endif
 }
 
 void Runtime::shutdown() {
+#ifdef __linux__
+    // Primeiro o reator, para soltar fibras paradas em E/S enquanto o
+    // agendador ainda pode executá-las
+    if (io_reactor) {
+        io_reactor->stop();
+    }
+#endif
     if (scheduler) {
         scheduler->stop();
     }
@@ -435,32 +2146,107 @@ GarbageCollector& Runtime::get_gc() {
     return *gc;
 }
 
+#ifdef __linux__
+IoReactor& Runtime::get_io() {
+    return *io_reactor;
+}
+#endif
+
 std::shared_ptr<Channel> Runtime::make_channel(size_t buffer_size) {
     return std::make_shared<Channel>(buffer_size);
 }
 
-void Runtime::spawn_fiber(std::function<void()> func) {
-    scheduler->spawn(std::move(func));
+void Runtime::spawn_fiber(detail::SmallFunc func, size_t stack_size) {
+    scheduler->spawn(std::move(func), stack_size);
 }
 
 void Runtime::sleep_ms(int milliseconds) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    scheduler->sleep_current(milliseconds);
 }
 
 void Runtime::set_global(const std::string& name, const Value& value) {
+    set_global(name, Value(value));
+}
+
+void Runtime::set_global(const std::string& name, Value&& value) {
     std::lock_guard<std::mutex> lock(globals_mutex);
-    globals[name] = value;
+    auto current = std::atomic_load_explicit(&globals_snapshot,
+                                             std::memory_order_acquire);
+    auto next = current ? std::make_shared<GlobalsMap>(*current)
+                        : std::make_shared<GlobalsMap>();
+    (*next)[name] = std::move(value);
+    std::atomic_store_explicit(
+        &globals_snapshot,
+        std::shared_ptr<const GlobalsMap>(std::move(next)),
+        std::memory_order_release);
 }
 
 std::optional<Value> Runtime::get_global(const std::string& name) const {
-    std::lock_guard<std::mutex> lock(globals_mutex);
-    auto it = globals.find(name);
-    if (it != globals.end()) {
+    auto snapshot = std::atomic_load_explicit(&globals_snapshot,
+                                              std::memory_order_acquire);
+    if (!snapshot) {
+        return std::nullopt;
+    }
+    auto it = snapshot->find(name);
+    if (it != snapshot->end()) {
         return it->second;
     }
     return std::nullopt;
 }
 
+LocalKey Runtime::local_key(const std::string& name) {
+    std::lock_guard<std::mutex> lock(local_keys_mutex);
+    auto it = local_keys.find(name);
+    if (it != local_keys.end()) {
+        return it->second;
+    }
+    LocalKey key = local_keys.size();
+    local_keys.emplace(name, key);
+    return key;
+}
+
+RuntimeStats Runtime::stats() const {
+    RuntimeStats snapshot;
+#ifndef AQUA_NO_STATS
+    {
+        std::lock_guard<std::mutex> lock(stats_registry_mutex);
+        for (const auto& block : stats_registry()) {
+            snapshot.fibers_executed +=
+                block->fibers_executed.load(std::memory_order_relaxed);
+            snapshot.steals += block->steals.load(std::memory_order_relaxed);
+            snapshot.channel_sends +=
+                block->channel_sends.load(std::memory_order_relaxed);
+            snapshot.channel_receives +=
+                block->channel_receives.load(std::memory_order_relaxed);
+            snapshot.channel_blocking_waits +=
+                block->channel_blocking_waits.load(std::memory_order_relaxed);
+            snapshot.gc_bytes_allocated +=
+                block->gc_bytes_allocated.load(std::memory_order_relaxed);
+            snapshot.gc_bytes_freed +=
+                block->gc_bytes_freed.load(std::memory_order_relaxed);
+            snapshot.gc_pause_ns +=
+                block->gc_pause_ns.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Profundidade das filas é um medidor instantâneo, não um contador:
+    // lido aqui, no caminho frio, direto das estruturas do agendador
+    if (scheduler) {
+        {
+            std::lock_guard<std::mutex> lock(scheduler->queue_mutex);
+            snapshot.queue_depth = scheduler->ready_queue.size();
+            for (const auto& box : scheduler->affinity_queues) {
+                snapshot.queue_depth += box.size();
+            }
+        }
+        for (const auto& queue : scheduler->local_queues) {
+            snapshot.queue_depth += queue->size();
+        }
+    }
+#endif
+    return snapshot;
+}
+
 Runtime& Runtime::get_instance() {
     if (!instance) {
         // Criar instância automaticamente se não existir
@@ -474,12 +2260,68 @@ std::shared_ptr<Channel> make_channel(size_t buffer_size) {
     return Runtime::get_instance().make_channel(buffer_size);
 }
 
-void spawn(std::function<void()> func) {
-    Runtime::get_instance().spawn_fiber(std::move(func));
+void spawn(detail::SmallFunc func, size_t stack_size) {
+    Runtime::get_instance().spawn_fiber(std::move(func), stack_size);
 }
 
 void sleep(int milliseconds) {
     Runtime::get_instance().sleep_ms(milliseconds);
 }
 
+SelectResult select(const std::vector<SelectCase>& cases, int timeout_ms) {
+    return Runtime::get_instance().select(cases, timeout_ms);
+}
+
+#ifdef __linux__
+namespace io {
+
+namespace {
+
+// As operações nunca podem bloquear a thread do worker: todo fd passa a
+// não bloqueante na primeira chamada
+void ensure_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0 && !(flags & O_NONBLOCK)) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+} // namespace
+
+ssize_t read(int fd, void* buf, size_t count) {
+    ensure_nonblocking(fd);
+    for (;;) {
+        ssize_t n = ::read(fd, buf, count);
+        if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return n;
+        }
+        Runtime::get_instance().get_io().wait_readable(fd);
+    }
+}
+
+ssize_t write(int fd, const void* buf, size_t count) {
+    ensure_nonblocking(fd);
+    for (;;) {
+        ssize_t n = ::write(fd, buf, count);
+        if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return n;
+        }
+        Runtime::get_instance().get_io().wait_writable(fd);
+    }
+}
+
+int accept(int fd, struct sockaddr* addr, socklen_t* addrlen) {
+    ensure_nonblocking(fd);
+    for (;;) {
+        int client = ::accept(fd, addr, addrlen);
+        if (client >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return client;
+        }
+        Runtime::get_instance().get_io().wait_readable(fd);
+    }
+}
+
+} // namespace io
+#endif // __linux__
+
 } // namespace aqua
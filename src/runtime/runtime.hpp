@@ -8,9 +8,22 @@
 #include <thread>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <deque>
 #include <string>
 #include <variant>
 #include <optional>
+#include <atomic>
+#include <array>
+#include <type_traits>
+#include <cstddef>
+#include <new>
+
+#ifdef __linux__
+#include <sys/types.h>
+#include <sys/socket.h>
+#endif
 
 namespace aqua {
 
@@ -19,9 +32,13 @@ class Fiber;
 class Channel;
 class Scheduler;
 class GarbageCollector;
+class IoReactor;
+class FiberPool;
 class Value;
+template <typename T> class TypedChannel;
 
-// Tipos de valores suportados
+// Tipos de valores suportados (mantido para compatibilidade de API; a
+// representação interna de Value é uma união etiquetada compacta)
 using ValueType = std::variant<
     std::nullptr_t,
     bool,
@@ -31,52 +48,347 @@ using ValueType = std::variant<
     std::shared_ptr<Channel>
 >;
 
-// Classe para representar valores na runtime
+namespace detail {
+
+// Célula refcontada que guarda os tipos de heap de um Value. A contagem é
+// atômica porque valores cruzam canais entre workers.
+struct RefCell {
+    std::atomic<size_t> refs{1};
+    bool interned{false};
+    virtual ~RefCell() = default;
+};
+
+struct StringCell : RefCell {
+    std::string str;
+
+    // Hash do conteúdo, fixado no internamento: o release escolhe o shard
+    // sem voltar a hashear a string
+    size_t hash{0};
+
+    explicit StringCell(std::string s) : str(std::move(s)) {}
+};
+
+struct ChannelCell : RefCell {
+    std::shared_ptr<Channel> channel;
+    explicit ChannelCell(std::shared_ptr<Channel> ch) : channel(std::move(ch)) {}
+};
+
+template<typename>
+inline constexpr bool always_false = false;
+
+// Tabela de internamento (ver intern.hpp/intern.cpp)
+StringCell* intern_cell(std::string_view text);
+void intern_release(RefCell* cell);
+
+// Espera compartilhada de um select: registrada em vários canais de uma
+// vez; o primeiro canal que ficar pronto sinaliza e acorda quem espera
+// (fibra estacionada ou thread na condvar). Quem espera reavalia os casos
+// e volta a dormir se perdeu a corrida.
+struct SelectWaiter {
+    std::mutex m;
+    std::condition_variable cv;
+    std::shared_ptr<Fiber> fiber;
+    bool signaled{false};
+
+    void notify();
+};
+
+// Invocável void() só-movimento com buffer interno: as lambdas típicas de
+// spawn — alguns ponteiros e inteiros capturados — cabem no buffer e criar
+// a fibra não aloca pelo caminho da função; alvos maiores caem no heap.
+// Substitui std::function no caminho de spawn (a roda de timers continua
+// com std::function: lá a alocação não é o gargalo).
+class SmallFunc {
+public:
+    SmallFunc() noexcept = default;
+
+    template <typename F,
+              typename = typename std::enable_if<!std::is_same<
+                  typename std::decay<F>::type, SmallFunc>::value>::type>
+    SmallFunc(F&& f) {
+        using Fn = typename std::decay<F>::type;
+        if constexpr (fits<Fn>()) {
+            new (&storage) Fn(std::forward<F>(f));
+        } else {
+            *reinterpret_cast<Fn**>(&storage) = new Fn(std::forward<F>(f));
+        }
+        invoke_fn = &invoke_impl<Fn>;
+        manage_fn = &manage_impl<Fn>;
+    }
+
+    SmallFunc(SmallFunc&& other) noexcept {
+        move_from(other);
+    }
+
+    SmallFunc& operator=(SmallFunc&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    SmallFunc(const SmallFunc&) = delete;
+    SmallFunc& operator=(const SmallFunc&) = delete;
+
+    ~SmallFunc() {
+        destroy();
+    }
+
+    void operator()() {
+        invoke_fn(&storage);
+    }
+
+    explicit operator bool() const noexcept {
+        return invoke_fn != nullptr;
+    }
+
+    // Solta o alvo (e tudo que ele capturou) sem esperar pela destruição;
+    // usado ao devolver uma fibra ao pool
+    void reset() noexcept {
+        destroy();
+        invoke_fn = nullptr;
+        manage_fn = nullptr;
+    }
+
+private:
+    // Seis ponteiros capturados ainda cabem inline
+    static constexpr size_t kBufferSize = 48;
+
+    enum class Op { MOVE, DESTROY };
+
+    template <typename Fn>
+    static constexpr bool fits() {
+        return sizeof(Fn) <= kBufferSize &&
+               alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template <typename Fn>
+    static void invoke_impl(void* storage) {
+        if constexpr (fits<Fn>()) {
+            (*reinterpret_cast<Fn*>(storage))();
+        } else {
+            (**reinterpret_cast<Fn**>(storage))();
+        }
+    }
+
+    // MOVE transfere o alvo de `storage` para `other` (inline: constrói por
+    // movimento e destrói a origem; heap: só copia o ponteiro)
+    template <typename Fn>
+    static void manage_impl(Op op, void* storage, void* other) {
+        if constexpr (fits<Fn>()) {
+            Fn* self = reinterpret_cast<Fn*>(storage);
+            if (op == Op::MOVE) {
+                new (other) Fn(std::move(*self));
+            }
+            self->~Fn();
+        } else {
+            Fn** slot = reinterpret_cast<Fn**>(storage);
+            if (op == Op::MOVE) {
+                *reinterpret_cast<Fn**>(other) = *slot;
+            } else {
+                delete *slot;
+            }
+        }
+    }
+
+    void move_from(SmallFunc& other) noexcept {
+        invoke_fn = other.invoke_fn;
+        manage_fn = other.manage_fn;
+        if (manage_fn) {
+            manage_fn(Op::MOVE, &other.storage, &storage);
+        }
+        other.invoke_fn = nullptr;
+        other.manage_fn = nullptr;
+    }
+
+    void destroy() noexcept {
+        if (manage_fn) {
+            manage_fn(Op::DESTROY, &storage, nullptr);
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[kBufferSize];
+    void (*invoke_fn)(void*){nullptr};
+    void (*manage_fn)(Op, void*, void*){nullptr};
+};
+
+} // namespace detail
+
+class InternedString;
+
+// Classe para representar valores na runtime. Representação compacta de 16
+// bytes: etiqueta + união de 8 bytes. Números e booleanos ficam inline (sem
+// alocação); strings e canais vivem numa célula refcontada compartilhada,
+// então copiar um Value nunca copia o payload.
 class Value {
+    enum class Tag : uint8_t {
+        Null,
+        Bool,
+        Int,
+        Float,
+        String,
+        Channel
+    };
+
 public:
-    Value() : data(std::nullptr_t{}) {}
-    Value(const ValueType& val) : data(val) {}
-    
-    template<typename T, typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, Value>>>
-    Value(T&& val) : data(std::forward<T>(val)) {}
-    
-    // Construtor de cópia
-    Value(const Value& other) : data(other.data) {}
-    
+    Value() : tag(Tag::Null) { payload.i = 0; }
+    Value(std::nullptr_t) : Value() {}
+    Value(bool val) : tag(Tag::Bool) { payload.b = val; }
+    Value(int val) : tag(Tag::Int) { payload.i = val; }
+    Value(long val) : tag(Tag::Int) { payload.i = val; }
+    Value(long long val) : tag(Tag::Int) { payload.i = val; }
+    Value(float val) : tag(Tag::Float) { payload.f = val; }
+    Value(double val) : tag(Tag::Float) { payload.f = val; }
+    // Strings passam pela tabela global de internamento: conteúdos idênticos
+    // compartilham uma única célula refcontada
+    Value(const char* val)
+        : tag(Tag::String) { payload.cell = detail::intern_cell(val); }
+    Value(const std::string& val)
+        : tag(Tag::String) { payload.cell = detail::intern_cell(val); }
+    Value(std::string&& val)
+        : tag(Tag::String) { payload.cell = detail::intern_cell(val); }
+    Value(const InternedString& val);
+    Value(std::shared_ptr<Channel> val)
+        : tag(Tag::Channel) { payload.cell = new detail::ChannelCell(std::move(val)); }
+
+    // Compatibilidade com o variant público
+    Value(const ValueType& val);
+
+    // Construtor de cópia: compartilha a célula, só incrementa a contagem
+    Value(const Value& other) : tag(other.tag), payload(other.payload) {
+        retain();
+    }
+
     // Construtor de movimento
-    Value(Value&& other) noexcept : data(std::move(other.data)) {}
-    
+    Value(Value&& other) noexcept : tag(other.tag), payload(other.payload) {
+        other.tag = Tag::Null;
+        other.payload.i = 0;
+    }
+
     // Operador de atribuição
     Value& operator=(const Value& other) {
         if (this != &other) {
-            data = other.data;
+            other.retain_cell();
+            release();
+            tag = other.tag;
+            payload = other.payload;
         }
         return *this;
     }
-    
+
     // Operador de atribuição de movimento
     Value& operator=(Value&& other) noexcept {
         if (this != &other) {
-            data = std::move(other.data);
+            release();
+            tag = other.tag;
+            payload = other.payload;
+            other.tag = Tag::Null;
+            other.payload.i = 0;
         }
         return *this;
     }
-    
+
+    ~Value() { release(); }
+
     template<typename T>
     T get() const {
-        return std::get<T>(data);
+        if (!is<T>()) {
+            throw std::bad_variant_access{};
+        }
+        if constexpr (std::is_same_v<T, std::nullptr_t>) {
+            return nullptr;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return payload.b;
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+            return payload.i;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return payload.f;
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return static_cast<detail::StringCell*>(payload.cell)->str;
+        } else if constexpr (std::is_same_v<T, std::shared_ptr<Channel>>) {
+            return static_cast<detail::ChannelCell*>(payload.cell)->channel;
+        } else {
+            static_assert(detail::always_false<T>, "tipo não suportado em Value");
+        }
     }
-    
+
     template<typename T>
     bool is() const {
-        return std::holds_alternative<T>(data);
+        if constexpr (std::is_same_v<T, std::nullptr_t>) {
+            return tag == Tag::Null;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return tag == Tag::Bool;
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+            return tag == Tag::Int;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return tag == Tag::Float;
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return tag == Tag::String;
+        } else if constexpr (std::is_same_v<T, std::shared_ptr<Channel>>) {
+            return tag == Tag::Channel;
+        } else {
+            static_assert(detail::always_false<T>, "tipo não suportado em Value");
+        }
     }
-    
+
     std::string type_name() const;
     std::string to_string() const;
-    
+
 private:
-    ValueType data;
+    friend class GarbageCollector;
+
+    union Payload {
+        bool b;
+        int64_t i;
+        double f;
+        detail::RefCell* cell;
+    };
+
+    Tag tag;
+    Payload payload;
+
+    // Acesso do coletor durante a marcação: endereço da célula de heap (se
+    // houver) e canal referenciado, sem passar pelo get<> que copia
+    detail::RefCell* heap_cell() const {
+        return has_cell() ? payload.cell : nullptr;
+    }
+
+    std::shared_ptr<Channel> channel_ref() const {
+        if (tag == Tag::Channel && payload.cell) {
+            return static_cast<detail::ChannelCell*>(payload.cell)->channel;
+        }
+        return nullptr;
+    }
+
+    bool has_cell() const {
+        return tag == Tag::String || tag == Tag::Channel;
+    }
+
+    void retain() { retain_cell(); }
+
+    void retain_cell() const {
+        if (has_cell() && payload.cell) {
+            payload.cell->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void release() {
+        if (has_cell() && payload.cell) {
+            if (payload.cell->interned) {
+                // Células internadas: o decremento que pode deixar só a
+                // referência da tabela acontece sob o lock do shard, ainda
+                // segurando a nossa referência (ver intern_release)
+                detail::intern_release(payload.cell);
+                return;
+            }
+            size_t prev = payload.cell->refs.fetch_sub(1, std::memory_order_acq_rel);
+            if (prev == 1) {
+                delete payload.cell;
+            }
+        }
+    }
 };
 
 // Classe para representar canais de comunicação
@@ -84,26 +396,127 @@ class Channel {
 public:
     Channel(size_t buffer_size = 0);
     ~Channel();
-    
-    // Operações de canal
+
+    // Operações de canal. A sobrecarga por rvalue move o valor até o
+    // buffer sem cópia profunda (a versão const& copia uma vez e delega)
     bool send(const Value& value);
+    bool send(Value&& value);
     std::optional<Value> receive();
+
+    // Variantes não bloqueantes (poll): retornam imediatamente quando o
+    // canal não está pronto
+    bool try_send(const Value& value);
+    std::optional<Value> try_receive();
+
+    // Operações em lote: movem vários valores sob uma única aquisição de
+    // lock e um único despertar, em vez de pagar ambos por mensagem.
+    // send_many envia o lote inteiro (bloqueando quando o canal enche) e
+    // retorna quantos entraram — menos que o lote só se o canal fechar.
+    // receive_many bloqueia até haver pelo menos um valor (ou o canal
+    // fechar), drena até max_n para `out` e retorna quantos escreveu.
+    size_t send_many(const std::vector<Value>& values);
+    size_t receive_many(std::vector<Value>& out, size_t max_n);
+
     void close();
     bool is_closed() const;
     bool is_empty() const;
     bool is_full() const;
-    
+
     // Getters
     size_t size() const;
     size_t capacity() const;
-    
+
 private:
-    std::queue<Value> buffer;
+    friend class GarbageCollector;
+    friend class Runtime;
+
+    // Caminho rápido para canais com buffer (max_size > 0): anel MPMC sem
+    // locks no estilo Vyukov; cada slot carrega um número de sequência que
+    // indica se está livre para escrita ou pronto para leitura.
+    struct RingSlot {
+        std::atomic<size_t> seq{0};
+        Value value;
+    };
+
+    // Canais sem buffer (max_size == 0) continuam na fila protegida por
+    // mutex (deque: o coletor percorre os valores pendentes na marcação)
+    std::deque<Value> buffer;
     size_t max_size;
     bool closed;
     mutable std::mutex mutex;
     std::condition_variable not_empty;
     std::condition_variable not_full;
+
+    std::unique_ptr<RingSlot[]> ring;
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> dequeue_pos{0};
+    std::atomic<bool> closed_flag{false};
+
+    // Quantos lados estão dormindo (fibras ou threads); permite pular o
+    // lock de notificação quando ninguém espera
+    std::atomic<int> recv_sleepers{0};
+    std::atomic<int> send_sleepers{0};
+
+    // Fibras bloqueadas neste canal (acordadas via Scheduler::unpark)
+    std::queue<std::shared_ptr<Fiber>> recv_waiters;
+    std::queue<std::shared_ptr<Fiber>> send_waiters;
+
+    // Esperas de select registradas neste canal (ver Runtime::select);
+    // protegidas pelo mutex do canal
+    std::vector<std::shared_ptr<detail::SelectWaiter>> recv_selects;
+    std::vector<std::shared_ptr<detail::SelectWaiter>> send_selects;
+
+    void add_select_waiter(const std::shared_ptr<detail::SelectWaiter>& waiter,
+                           bool for_receive);
+    void remove_select_waiter(const detail::SelectWaiter* waiter,
+                              bool for_receive);
+    static void notify_selects(
+        std::vector<std::shared_ptr<detail::SelectWaiter>>& waiters);
+
+    // A versão rvalue só move o valor no ponto de sucesso, então os laços
+    // de retry dos chamadores podem repassá-la com std::move
+    bool try_ring_send(const Value& value);
+    bool try_ring_send(Value&& value);
+    std::optional<Value> try_ring_receive();
+    void wake_receiver();
+    void wake_sender();
+
+    // Versões em lote: acordam até `count` esperas de uma vez
+    void wake_receivers(size_t count);
+    void wake_senders(size_t count);
+
+    // Bloqueia a fibra corrente na fila dada, soltando o lock do canal
+    // durante a suspensão. Pré-condição: chamado de dentro de uma fibra.
+    void block_fiber(std::unique_lock<std::mutex>& lock,
+                     std::queue<std::shared_ptr<Fiber>>& waiters);
+    void wake_one(std::queue<std::shared_ptr<Fiber>>& waiters);
+    void wake_all_locked();
+};
+
+// Chave de armazenamento local de fibra: um índice pequeno entregue uma
+// única vez pela Runtime (ver Runtime::local_key); indexa direto o vetor
+// de locais da fibra, sem hash de string no caminho quente
+using LocalKey = size_t;
+
+// Um caso de select: receber de um canal ou enviar um valor para ele
+struct SelectCase {
+    static SelectCase receive(std::shared_ptr<Channel> channel);
+    static SelectCase send(std::shared_ptr<Channel> channel, Value value);
+
+    bool is_receive{true};
+    std::shared_ptr<Channel> channel;
+    Value value; // valor a enviar (apenas casos de envio)
+};
+
+// Resultado de um select: índice do caso atendido (npos se o prazo
+// venceu). Para receives, `value` traz o valor recebido (nullopt se o
+// canal fechou); para sends, `sent` indica se o envio aconteceu.
+struct SelectResult {
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    size_t index{npos};
+    std::optional<Value> value;
+    bool sent{false};
 };
 
 // Classe para representar uma fibra (coroutine)
@@ -116,152 +529,748 @@ public:
         FINISHED,
         ERROR
     };
-    
-    Fiber(std::function<void()> func);
+
+    // stack_size == 0 usa o tamanho padrão da runtime; valores explícitos
+    // são arredondados para múltiplos de página (ver StackPool)
+    explicit Fiber(detail::SmallFunc func, size_t stack_size = 0);
     ~Fiber();
-    
+
     // Controle da fibra
     void start();
     void yield();
     void resume();
     void wait();
     void finish();
-    
+
     // Getters
     State get_state() const;
     size_t get_id() const;
     bool is_finished() const;
-    
-    // Contexto da fibra
+
+    // Contexto da fibra: acesso por slot (caminho rápido; o vetor cresce
+    // sob demanda e só existe quando a fibra usa locais)
+    void set_local(LocalKey key, const Value& value);
+    void set_local(LocalKey key, Value&& value);
+    std::optional<Value> get_local(LocalKey key) const;
+
+    // Compatibilidade: resolve o nome para um LocalKey global e delega
     void set_local(const std::string& key, const Value& value);
+    void set_local(const std::string& key, Value&& value);
     std::optional<Value> get_local(const std::string& key) const;
-    
+
 private:
+    friend class Scheduler;
+    friend class Channel;
+    friend class GarbageCollector;
+    friend class FiberPool;
+
+    // Motivo pelo qual a fibra devolveu controle ao worker. Escrito apenas
+    // pela própria fibra antes de suspender; lido apenas pelo worker.
+    enum class SuspendReason {
+        YIELDED,   // yield voluntário: reenfileirar imediatamente
+        BLOCKED    // esperando canal/evento: só volta via unpark
+    };
+
     static size_t next_id;
     size_t id;
-    State state;
-    std::function<void()> function;
-    std::unordered_map<std::string, Value> locals;
-    
-    // Contexto de execução (será implementado com ucontext ou similar)
+    std::atomic<State> state;
+    detail::SmallFunc function;
+
+    // Locais da fibra, indexados por LocalKey; locals_present distingue um
+    // slot nunca escrito de um que guarda null. O mutex serializa o acesso
+    // da própria fibra com a varredura de raízes do coletor.
+    std::vector<Value> locals;
+    std::vector<bool> locals_present;
+    mutable std::mutex locals_mutex;
+
+    // Contexto de execução (ucontext)
     void* context;
     void* stack;
     size_t stack_size;
-    
+
+    SuspendReason suspend_reason{SuspendReason::YIELDED};
+
+    // Último worker que executou esta fibra (SIZE_MAX: nunca rodou). Usado
+    // pelo agendador para devolver despertares ao worker de origem, onde
+    // pilha e dados ainda estão quentes no cache/nó de memória.
+    size_t last_worker{static_cast<size_t>(-1)};
+
+    // Protocolo de handoff entre o worker que estaciona a fibra e quem a
+    // acorda: evita retomar um contexto que ainda não foi salvo.
+    std::mutex wake_mutex;
+    bool parked{false};
+    bool wake_pending{false};
+
+    // Auto-referência que mantém a fibra viva enquanto circula pelas filas
+    // como ponteiro cru; desfeita quando a fibra termina.
+    std::shared_ptr<Fiber> self_ref;
+
     void setup_context();
     void cleanup_context();
+
+    // Aponta o ucontext existente de volta para o trampoline (usado na
+    // criação e ao reciclar a fibra com a mesma pilha)
+    void arm_context();
+
+    // Reinicializa uma fibra vinda do pool como recém-construída: id novo,
+    // pilha/contexto reaproveitados quando o tamanho bate, vetores de
+    // locais com a capacidade da encarnação anterior
+    void reset_for_reuse(detail::SmallFunc func, size_t stack_size_hint);
+
+    // Solta o alvo da função e os locais ao entrar no pool (capturas podem
+    // segurar canais e valores); a capacidade dos vetores fica retida
+    void scrub();
+
+    // Corpo executado dentro do contexto da fibra (trampoline)
+    void run();
+    static void trampoline(unsigned int hi, unsigned int lo);
+
+    // Salva o contexto da fibra e devolve controle ao worker
+    void suspend(SuspendReason reason);
+};
+
+// Configuração do agendador. Com pin_workers, cada worker é fixado num
+// CPU (da lista `cpus`, repetida se mais curta que o número de workers;
+// vazia distribui em sequência pelos CPUs online). Fixar os workers dá
+// localidade de nó NUMA de graça pela política first-touch do kernel: as
+// pilhas de fibra (mmap) e os anéis de canal tocados por um worker fixado
+// ficam no nó dele, e a preferência de despertar pelo último worker (ver
+// Fiber::last_worker) mantém a fibra voltando para lá.
+struct SchedulerOptions {
+    size_t num_workers{0}; // 0: um por CPU de hardware
+    bool pin_workers{false};
+    std::vector<int> cpus;
 };
 
 // Agendador de fibras
 class Scheduler {
 public:
     Scheduler(size_t num_threads = std::thread::hardware_concurrency());
+    explicit Scheduler(const SchedulerOptions& options);
     ~Scheduler();
-    
-    // Gerenciamento de fibras
-    void spawn(std::function<void()> func);
+
+    // Gerenciamento de fibras. stack_size == 0 usa o padrão da runtime;
+    // fibras com pilha profunda (recursão, buffers locais) podem pedir mais.
+    // Fibras terminadas voltam a um pool por thread e spawns futuros as
+    // reciclam em vez de construir do zero.
+    void spawn(detail::SmallFunc func, size_t stack_size = 0);
     void yield();
+
+    // Dorme por `milliseconds`: numa fibra, suspende só a fibra (a roda de
+    // timers a reenfileira no vencimento); fora de fibra, dorme a thread
+    void sleep_current(int milliseconds);
     void wait_all();
-    
+
     // Controle do agendador
     void start();
     void stop();
     bool is_running() const;
-    
+
     // Estatísticas
     size_t active_fibers() const;
     size_t total_fibers() const;
-    
+
 private:
+    friend class Channel;
+    friend class GarbageCollector;
+    friend class Runtime;
+    friend class WaitGroup;
+    friend struct detail::SelectWaiter;
+    friend class IoReactor;
+    template <typename T> friend class TypedChannel;
+
+    // Deque de roubo de trabalho (Chase-Lev, capacidade fixa): o worker dono
+    // faz push/pop no fundo sem locks; ladrões tiram do topo via CAS.
+    class WorkStealingDeque {
+    public:
+        bool push(Fiber* fiber);   // apenas o worker dono
+        Fiber* pop();              // apenas o worker dono
+        Fiber* steal();            // qualquer thread
+        size_t size() const;       // aproximado; só para diagnóstico
+
+    private:
+        static constexpr size_t kCapacity = 4096; // potência de dois
+        static constexpr size_t kMask = kCapacity - 1;
+
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        std::array<std::atomic<Fiber*>, kCapacity> buffer{};
+    };
+
+    // Roda de timers hierárquica: 4 níveis de 64 slots com tique de 1 ms
+    // (alcances de ~64 ms, ~4 s, ~4 min e ~4,5 h). Inserção e disparo são
+    // O(1); uma thread dedicada avança a roda, cascateia níveis superiores
+    // e dispara os despertares vencidos. Dorme bloqueada quando não há
+    // timers armados.
+    class TimerWheel {
+    public:
+        void start();
+        void stop();
+
+        // Agenda `wake` para daqui a `delay_ms` milissegundos
+        void schedule(uint64_t delay_ms, std::function<void()> wake);
+
+    private:
+        static constexpr size_t kLevels = 4;
+        static constexpr uint64_t kSlotBits = 6;
+        static constexpr size_t kSlotsPerLevel = 1u << kSlotBits;
+        static constexpr uint64_t kSlotMask = kSlotsPerLevel - 1;
+
+        struct Timer {
+            uint64_t deadline; // em tiques (ms) desde o início da roda
+            std::function<void()> wake;
+        };
+
+        std::array<std::array<std::vector<Timer>, kSlotsPerLevel>, kLevels> slots;
+        uint64_t current_tick{0};
+        size_t armed{0};
+        bool running{false};
+
+        std::mutex m;
+        std::condition_variable cv;
+        std::thread thread;
+        std::chrono::steady_clock::time_point epoch;
+
+        void run();
+        void insert_locked(Timer timer);
+
+        // Avança a roda até `target`, cascateando e coletando os vencidos
+        void advance_locked(uint64_t target, std::vector<Timer>& due);
+    };
+
+    SchedulerOptions options;
+    size_t num_workers;
     std::vector<std::thread> workers;
-    std::queue<std::shared_ptr<Fiber>> ready_queue;
-    std::vector<std::shared_ptr<Fiber>> running_fibers;
-    std::vector<std::shared_ptr<Fiber>> waiting_fibers;
-    
+    std::vector<std::unique_ptr<WorkStealingDeque>> local_queues;
+    TimerWheel timer_wheel;
+
+    // Fila externa: recebe spawns de threads que não são workers e o
+    // transbordo das filas locais quando enchem.
+    std::queue<Fiber*> ready_queue;
+
+    // Caixas de afinidade, uma por worker: despertares vindos de fora dos
+    // workers (timers, reator de E/S) vão para a caixa do último worker da
+    // fibra em vez da fila global. Preferência, não obrigação: workers
+    // ociosos drenam caixas alheias para ninguém ficar esperando à toa.
+    // Protegidas pelo mesmo queue_mutex da fila externa.
+    std::vector<std::queue<Fiber*>> affinity_queues;
+
     mutable std::mutex queue_mutex;
     std::condition_variable worker_condition;
-    bool running;
-    
-    void worker_loop();
-    void schedule_fiber(std::shared_ptr<Fiber> fiber);
-    std::shared_ptr<Fiber> get_next_fiber();
+    std::atomic<bool> running;
+
+    // Junção sem polling: a última fibra a terminar acorda quem espera em
+    // wait_all
+    mutable std::mutex wait_mutex;
+    std::condition_variable wait_condition;
+
+    // Fibras vivas (prontas, executando ou bloqueadas) e executando agora
+    std::atomic<size_t> outstanding_fibers{0};
+    std::atomic<size_t> running_count{0};
+
+    // Registro de todas as fibras vivas, para a varredura de raízes do
+    // coletor; o mutex também protege o reset de self_ref ao terminar
+    std::unordered_set<Fiber*> live_fibers;
+    mutable std::mutex fibers_mutex;
+
+    void worker_loop(size_t worker_index);
+    void schedule_fiber(Fiber* fiber);
+    Fiber* get_next_fiber(size_t worker_index);
+    Fiber* pop_external(size_t worker_index);
+
+    // Estaciona uma fibra que suspendeu esperando um evento, resolvendo a
+    // corrida com um unpark que chegue antes do contexto ser salvo.
+    void park_fiber(Fiber* fiber);
+
+    // Reenfileira uma fibra bloqueada (chamado por canais e afins)
+    void unpark(const std::shared_ptr<Fiber>& fiber);
+
+    // Solta as fibras que ainda estavam enfileiradas quando o agendador parou
+    void drain_queues();
+
+    // Instantâneo das fibras vivas (handles fortes) para o coletor
+    std::vector<std::shared_ptr<Fiber>> snapshot_fibers() const;
+
+    // Agenda um despertar na roda de timers (usado por sleep e select)
+    void schedule_timer(uint64_t delay_ms, std::function<void()> wake);
+
+    // Fibra atualmente em execução neste worker (nullptr fora de fibras)
+    static Fiber* current_fiber();
+    static std::shared_ptr<Fiber> current_fiber_handle();
+
+    // Suspende a fibra corrente até unpark; pré-condição: current_fiber()
+    static void suspend_current();
 };
 
-// Coletor de lixo simples
+// Junção no estilo Go: add registra trabalho pendente, done conclui uma
+// unidade e wait bloqueia até o contador zerar — fibras são suspensas e
+// acordadas via unpark, threads esperam na condvar; nada de polling.
+class WaitGroup {
+public:
+    void add(size_t n = 1);
+    void done();
+    void wait();
+
+private:
+    std::atomic<int64_t> count{0};
+    std::mutex m;
+    std::condition_variable cv;
+    std::vector<std::shared_ptr<Fiber>> waiting_fibers;
+};
+
+#ifdef __linux__
+// Reator de E/S assíncrona sobre epoll: uma thread dedicada espera pelos
+// descritores registrados e reenfileira as fibras quando ficam prontos. As
+// operações de aqua::io tentam em modo não bloqueante e, em EAGAIN,
+// registram o descritor aqui e suspendem só a fibra — o worker fica livre
+// para executar outras. Fora de fibra (ou com o reator parado), a espera
+// degrada para poll() bloqueante na própria thread.
+class IoReactor {
+public:
+    IoReactor();
+    ~IoReactor();
+
+    void start();
+    void stop();
+
+    // Suspende a fibra corrente até `fd` ficar legível/escrevível.
+    // Despertares espúrios são possíveis: o chamador repete a operação e
+    // volta a esperar se receber EAGAIN de novo.
+    void wait_readable(int fd);
+    void wait_writable(int fd);
+
+private:
+    struct Waiter {
+        bool for_write;
+        std::shared_ptr<Fiber> fiber;
+    };
+
+    int epoll_fd{-1};
+    int wake_fd{-1};   // eventfd para acordar/encerrar a thread do reator
+    std::atomic<bool> running{false};
+    std::thread thread;
+
+    // fd → fibras esperando por ele; o interesse armado no epoll é sempre
+    // a união das direções pendentes, e o fd sai do epoll ao disparar
+    std::mutex m;
+    std::unordered_map<int, std::vector<Waiter>> waiters;
+
+    void run();
+    void wait_event(int fd, bool for_write);
+
+    // (Re)arma `fd` no epoll com a união dos interesses; mutex tomado
+    void arm_locked(int fd, bool already_armed);
+};
+#endif
+
+// Coletor de lixo com rastreamento preciso e marcação incremental. As
+// raízes são as globais da Runtime, os locais de cada fibra viva e os
+// valores pendentes nos buffers de canais; a marcação avança em fatias de
+// trabalho limitado entre trocas de fibra, então as pausas ficam na casa
+// do orçamento de uma fatia em vez de parar todos os workers.
 class GarbageCollector {
 public:
     GarbageCollector();
     ~GarbageCollector();
-    
+
     // Gerenciamento de memória
     void register_object(void* ptr, size_t size);
     void unregister_object(void* ptr);
+
+    // Executa um ciclo completo (marcação até o fim + varredura)
     void collect();
-    
+
+    // Avança um ciclo em andamento em até `budget` unidades de trabalho
+    // (valores/objetos visitados); retorna true quando não há mais o que
+    // fazer. Chamado pelos workers entre trocas de fibra.
+    bool collect_step(size_t budget = kDefaultSliceBudget);
+
+    // Alocação para objetos da runtime: bump-pointer em blocos locais de
+    // thread (TLAB) esculpidos de pedaços grandes. O caminho comum é um
+    // incremento de ponteiro sem lock; o coletor registra blocos inteiros,
+    // não objetos individuais. A memória devolvida pertence ao coletor e é
+    // liberada na varredura quando nenhuma raiz a alcança.
+    void* gc_alloc(size_t size);
+
     // Configuração
     void set_threshold(size_t threshold);
     size_t get_threshold() const;
-    
+
     // Estatísticas
     size_t allocated_objects() const;
     size_t total_memory() const;
-    
+
+    // Orçamento padrão de uma fatia de marcação
+    static constexpr size_t kDefaultSliceBudget = 256;
+
 private:
     struct ObjectInfo {
         void* ptr;
         size_t size;
         bool marked;
+        bool owned{false};   // alocado via gc_alloc: a varredura libera
+        bool pinned{false};  // bloco TLAB ativo: nunca varrido
     };
-    
-    std::unordered_map<void*, ObjectInfo> objects;
+
+    // Mapa ordenado por endereço: a marcação precisa achar o objeto que
+    // contém um ponteiro interior (objetos TLAB apontam para dentro do bloco)
+    std::map<void*, ObjectInfo> objects;
     size_t memory_threshold;
     size_t total_allocated;
-    
+
     mutable std::mutex gc_mutex;
-    
-    void mark_and_sweep();
-    void mark_reachable_objects();
+
+    // Estado do ciclo incremental: raízes ainda não visitadas e canais
+    // cinzas (descobertos mas com buffers ainda não varridos)
+    enum class Phase { IDLE, MARKING };
+    Phase phase{Phase::IDLE};
+    std::vector<Value> pending_roots;
+    std::vector<std::shared_ptr<Channel>> gray_channels;
+    std::unordered_set<const Channel*> seen_channels;
+
+    // Começa um ciclo: limpa marcas e captura as raízes. Sem barreira de
+    // escrita, valores que migram durante a marcação podem escapar de um
+    // ciclo; serão vistos no próximo.
+    void begin_cycle_locked();
+    bool step_locked(size_t budget);
+    void mark_value(const Value& value);
+    void mark_address(const void* ptr);
+    size_t scan_channel(const std::shared_ptr<Channel>& channel);
     void sweep_unreachable_objects();
 };
 
+// Instantâneo agregado dos contadores de instrumentação da runtime (ver
+// Runtime::stats()). Os contadores são por thread e relaxed — baratos nos
+// caminhos quentes — e somados sob demanda; compilar com -DAQUA_NO_STATS
+// elimina toda a instrumentação e o instantâneo volta zerado.
+struct RuntimeStats {
+    uint64_t fibers_executed{0};       // fibras levadas até o fim
+    uint64_t steals{0};                // roubos de trabalho bem-sucedidos
+    uint64_t queue_depth{0};           // fibras prontas enfileiradas agora
+    uint64_t channel_sends{0};         // valores enfileirados em canais
+    uint64_t channel_receives{0};      // valores retirados de canais
+    uint64_t channel_blocking_waits{0}; // vezes que send/receive bloqueou
+    uint64_t gc_bytes_allocated{0};    // bytes registrados no coletor
+    uint64_t gc_bytes_freed{0};        // bytes varridos ou desregistrados
+    uint64_t gc_pause_ns{0};           // tempo acumulado nas fatias de GC
+};
+
 // Runtime principal da linguagem Aqua
 class Runtime {
 public:
     Runtime();
     ~Runtime();
-    
+
     // Inicialização e finalização
     void initialize();
     void shutdown();
-    
+
     // Acesso aos componentes
     Scheduler& get_scheduler();
     GarbageCollector& get_gc();
-    
+#ifdef __linux__
+    IoReactor& get_io();
+#endif
+
     // Funções utilitárias
     std::shared_ptr<Channel> make_channel(size_t buffer_size = 0);
-    void spawn_fiber(std::function<void()> func);
+    void spawn_fiber(detail::SmallFunc func, size_t stack_size = 0);
     void sleep_ms(int milliseconds);
-    
-    // Variáveis globais
+
+    // Bloqueia até que algum dos casos esteja pronto e o executa.
+    // timeout_ms < 0 espera sem prazo; 0 só faz poll; > 0 espera até o
+    // prazo. Sem polling: a espera registra-se nos canais envolvidos e é
+    // acordada pela maquinária de not_empty/not_full deles.
+    SelectResult select(const std::vector<SelectCase>& cases,
+                        int timeout_ms = -1);
+
+    // Variáveis globais. Leitura carrega o instantâneo corrente sem tocar
+    // em lock nenhum (globais são lidas milhões de vezes e escritas quase
+    // só na inicialização); escrita copia o mapa e publica a nova versão.
     void set_global(const std::string& name, const Value& value);
+    void set_global(const std::string& name, Value&& value);
     std::optional<Value> get_global(const std::string& name) const;
-    
+
+    // Entrega o LocalKey de `name`, criando-o na primeira vez; o mesmo
+    // nome devolve sempre o mesmo índice
+    LocalKey local_key(const std::string& name);
+
+    // Soma os contadores por thread num instantâneo para diagnóstico.
+    // As leituras são relaxed: os totais são consistentes o bastante para
+    // observabilidade, sem perturbar os caminhos que medem.
+    RuntimeStats stats() const;
+
 private:
+    friend class GarbageCollector;
+
     std::unique_ptr<Scheduler> scheduler;
     std::unique_ptr<GarbageCollector> gc;
-    std::unordered_map<std::string, Value> globals;
+#ifdef __linux__
+    std::unique_ptr<IoReactor> io_reactor;
+#endif
+
+    // Globais como instantâneo imutável trocado atomicamente (copy-on-
+    // write, estilo RCU): leitores fazem atomic_load do shared_ptr e
+    // consultam sem lock; o mutex serializa apenas escritores, que copiam
+    // o mapa e publicam a versão nova. Versões antigas morrem quando o
+    // último leitor solta o shared_ptr.
+    using GlobalsMap = std::unordered_map<std::string, Value>;
+    std::shared_ptr<const GlobalsMap> globals_snapshot;
     mutable std::mutex globals_mutex;
-    
+
+    // Registro nome → LocalKey (só no caminho de compatibilidade)
+    std::unordered_map<std::string, LocalKey> local_keys;
+    std::mutex local_keys_mutex;
+
     static Runtime* instance;
-    
+
 public:
     static Runtime& get_instance();
 };
 
+// Canal tipado para cargas de um único tipo trivialmente copiável: o anel
+// guarda T contíguo, sem boxing em Value (nem variantes nem shared_ptr por
+// mensagem) — o mesmo protocolo de sequências por slot do anel do Channel,
+// com a mesma disciplina de bloqueio (registrar-se como dormente e tentar
+// de novo antes de suspender). Sempre com buffer (capacidade mínima 1).
+// Como T não carrega referências, o coletor não precisa varrer estes
+// canais. O Channel dinâmico continua sendo o tipo dos canais da
+// linguagem (make_channel); este template é para os caminhos quentes do
+// código hospedeiro com tipo conhecido.
+template <typename T>
+class TypedChannel {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "TypedChannel<T> exige T trivialmente copiável");
+
+public:
+    explicit TypedChannel(size_t buffer_size)
+        : max_size(buffer_size == 0 ? 1 : buffer_size),
+          ring(new Slot[max_size]) {
+        for (size_t i = 0; i < max_size; ++i) {
+            ring[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool send(const T& value) {
+        if (closed_flag.load()) {
+            return false;
+        }
+        if (try_ring_send(value)) {
+            wake_receiver();
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            if (closed_flag.load()) {
+                return false;
+            }
+            send_sleepers.fetch_add(1);
+            if (try_ring_send(value)) {
+                send_sleepers.fetch_sub(1);
+                lock.unlock();
+                wake_receiver();
+                return true;
+            }
+            if (Scheduler::current_fiber()) {
+                block_fiber(lock, send_waiters);
+            } else {
+                not_full.wait(lock);
+            }
+            send_sleepers.fetch_sub(1);
+        }
+    }
+
+    std::optional<T> receive() {
+        if (auto value = try_ring_receive()) {
+            wake_sender();
+            return value;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            recv_sleepers.fetch_add(1);
+            if (auto value = try_ring_receive()) {
+                recv_sleepers.fetch_sub(1);
+                lock.unlock();
+                wake_sender();
+                return value;
+            }
+            if (closed_flag.load()) {
+                recv_sleepers.fetch_sub(1);
+                return std::nullopt;
+            }
+            if (Scheduler::current_fiber()) {
+                block_fiber(lock, recv_waiters);
+            } else {
+                not_empty.wait(lock);
+            }
+            recv_sleepers.fetch_sub(1);
+        }
+    }
+
+    bool try_send(const T& value) {
+        if (closed_flag.load()) {
+            return false;
+        }
+        if (try_ring_send(value)) {
+            wake_receiver();
+            return true;
+        }
+        return false;
+    }
+
+    std::optional<T> try_receive() {
+        if (auto value = try_ring_receive()) {
+            wake_sender();
+            return value;
+        }
+        return std::nullopt;
+    }
+
+    void close() {
+        closed_flag.store(true);
+        std::unique_lock<std::mutex> lock(mutex);
+        Scheduler& scheduler = Runtime::get_instance().get_scheduler();
+        while (!recv_waiters.empty()) {
+            scheduler.unpark(recv_waiters.front());
+            recv_waiters.pop();
+        }
+        while (!send_waiters.empty()) {
+            scheduler.unpark(send_waiters.front());
+            send_waiters.pop();
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    bool is_closed() const { return closed_flag.load(); }
+
+    size_t size() const {
+        size_t enq = enqueue_pos.load(std::memory_order_acquire);
+        size_t deq = dequeue_pos.load(std::memory_order_acquire);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    size_t capacity() const { return max_size; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq{0};
+        T value;
+    };
+
+    bool try_ring_send(const T& value) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = ring[pos % max_size];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // anel cheio
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::optional<T> try_ring_receive() {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = ring[pos % max_size];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            auto diff =
+                static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    T value = slot.value;
+                    slot.seq.store(pos + max_size, std::memory_order_release);
+                    return value;
+                }
+            } else if (diff < 0) {
+                return std::nullopt; // anel vazio
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void block_fiber(std::unique_lock<std::mutex>& lock,
+                     std::queue<std::shared_ptr<Fiber>>& waiters) {
+        waiters.push(Scheduler::current_fiber_handle());
+        lock.unlock();
+        Scheduler::suspend_current();
+        lock.lock();
+    }
+
+    void wake_receiver() {
+        if (recv_sleepers.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!recv_waiters.empty()) {
+                Runtime::get_instance().get_scheduler().unpark(
+                    recv_waiters.front());
+                recv_waiters.pop();
+            }
+            not_empty.notify_one();
+        }
+    }
+
+    void wake_sender() {
+        if (send_sleepers.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!send_waiters.empty()) {
+                Runtime::get_instance().get_scheduler().unpark(
+                    send_waiters.front());
+                send_waiters.pop();
+            }
+            not_full.notify_one();
+        }
+    }
+
+    size_t max_size;
+    std::unique_ptr<Slot[]> ring;
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> dequeue_pos{0};
+    std::atomic<bool> closed_flag{false};
+
+    std::atomic<int> recv_sleepers{0};
+    std::atomic<int> send_sleepers{0};
+
+    mutable std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::queue<std::shared_ptr<Fiber>> recv_waiters;
+    std::queue<std::shared_ptr<Fiber>> send_waiters;
+};
+
 // Funções utilitárias globais
 std::shared_ptr<Channel> make_channel(size_t buffer_size = 0);
-void spawn(std::function<void()> func);
+
+template <typename T>
+std::shared_ptr<TypedChannel<T>> make_typed_channel(size_t buffer_size = 1) {
+    return std::make_shared<TypedChannel<T>>(buffer_size);
+}
+
+void spawn(detail::SmallFunc func, size_t stack_size = 0);
 void sleep(int milliseconds);
+SelectResult select(const std::vector<SelectCase>& cases, int timeout_ms = -1);
+
+#ifdef __linux__
+// E/S consciente de fibras: mesma semântica das chamadas POSIX (valor de
+// retorno e errno), mas em EAGAIN só a fibra suspende — o worker segue
+// executando outras. O descritor é posto em modo não bloqueante na
+// primeira chamada. Fora de fibra, equivalem às chamadas bloqueantes.
+namespace io {
+ssize_t read(int fd, void* buf, size_t count);
+ssize_t write(int fd, const void* buf, size_t count);
+int accept(int fd, struct sockaddr* addr, socklen_t* addrlen);
+} // namespace io
+#endif
 
 } // namespace aqua